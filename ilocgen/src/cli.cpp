@@ -0,0 +1,165 @@
+#include "cli.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+void print_help() {
+    std::cout << "Usage: ilocgen [options]" << std::endl;
+    std::cout << "Write a random, valid ILOC block to stdout." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -h        Print this help message" << std::endl;
+    std::cout << "  -n <ops>  Number of ops; K and M suffixes allowed (default 1000)" << std::endl;
+    std::cout << "  -s <seed> Random seed; the same seed and options give the same" << std::endl;
+    std::cout << "            file (default 1)" << std::endl;
+    std::cout << "  -o <file> Write to <file> instead of stdout" << std::endl;
+    std::cout << "  --mix <op>=<weight>,..." << std::endl;
+    std::cout << "            Relative frequency of each opcode (loadI load store add" << std::endl;
+    std::cout << "            sub mult lshift rshift output nop); unnamed opcodes keep" << std::endl;
+    std::cout << "            their defaults: loadI=15,load=10,store=10,add=20,sub=10," << std::endl;
+    std::cout << "            mult=10,lshift=5,rshift=5,output=2,nop=0" << std::endl;
+    std::cout << "  --live <n>" << std::endl;
+    std::cout << "            Register pressure: values kept live at once (default 16)" << std::endl;
+    std::cout << "  --reuse <p>" << std::endl;
+    std::cout << "            Chance a load, store or output reuses an address" << std::endl;
+    std::cout << "            (0 to 1, default 0.5)" << std::endl;
+    std::cout << "  --comments <p>" << std::endl;
+    std::cout << "            Chance an op gets a comment (0 to 1, default 0)" << std::endl;
+    std::cout << "  --depth <p>" << std::endl;
+    std::cout << "            Chance an operand is the value defined just before it:" << std::endl;
+    std::cout << "            0 gives many short chains, 1 one long chain (default 0.3)" << std::endl;
+}
+
+// 10K, 2M, 1500
+static bool parseCount(const std::string& text, long long& count) {
+    if (text.empty()) return false;
+    long long scale = 1;
+    std::string digits = text;
+    char suffix = text.back();
+    if (suffix == 'k' || suffix == 'K') scale = 1000;
+    if (suffix == 'm' || suffix == 'M') scale = 1000000;
+    if (scale != 1) digits.pop_back();
+    if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) return false;
+    try {
+        count = std::stoll(digits) * scale;
+    } catch (std::exception&) {
+        return false;
+    }
+    return count > 0 && count <= 1000000000LL;
+}
+
+static bool parseProbability(const std::string& text, double& p) {
+    try {
+        size_t used = 0;
+        p = std::stod(text, &used);
+        return used == text.size() && p >= 0.0 && p <= 1.0;
+    } catch (std::exception&) {
+        return false;
+    }
+}
+
+static bool parseMix(const std::string& text, int weights[GEN_OPCODE_COUNT], std::string& error) {
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) end = text.size();
+        std::string item = text.substr(start, end - start);
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            error = "Invalid --mix entry '" + item + "': expected <op>=<weight>";
+            return false;
+        }
+
+        std::string name = item.substr(0, eq);
+        int op = 0;
+        while (op < GEN_OPCODE_COUNT && name != Generator::opcodeName(op)) op++;
+        if (op == GEN_OPCODE_COUNT) {
+            error = "Unknown opcode in --mix: " + name;
+            return false;
+        }
+
+        std::string weight = item.substr(eq + 1);
+        if (weight.empty() || weight.find_first_not_of("0123456789") != std::string::npos ||
+            weight.size() > 6) {
+            error = "Invalid weight for " + name + ": '" + weight + "'";
+            return false;
+        }
+        weights[op] = std::stoi(weight);
+        start = end + 1;
+    }
+
+    int total = 0;
+    for (int op = 0; op < GEN_OPCODE_COUNT; op++) total += weights[op];
+    if (total <= 0) {
+        error = "--mix: at least one opcode needs a positive weight";
+        return false;
+    }
+    return true;
+}
+
+CLIOptions parse_arguments(int argc, char* argv[]) {
+    CLIOptions result;
+    result.valid = true;
+    result.mode = MODE_GENERATE;
+
+    auto fail = [&result](const std::string& message) {
+        result.valid = false;
+        result.errorMessage = message;
+        return result;
+    };
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool takesValue = (arg == "-n" || arg == "-s" || arg == "-o" || arg == "--mix" ||
+                           arg == "--live" || arg == "--reuse" || arg == "--comments" || arg == "--depth");
+
+        if (arg == "-h") {
+            result.mode = MODE_HELP;
+            return result;
+        }
+        if (!takesValue) {
+            return fail("Unknown option: " + arg + ". Run ilocgen -h for usage.");
+        }
+        if (i + 1 >= argc) {
+            return fail(arg + " requires a value");
+        }
+        std::string value = argv[++i];
+
+        if (arg == "-n") {
+            if (!parseCount(value, result.config.ops)) {
+                return fail("Invalid op count: '" + value + "'");
+            }
+        } else if (arg == "-s") {
+            if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+                return fail("Invalid seed: '" + value + "'");
+            }
+            try {
+                result.config.seed = std::stoull(value);
+            } catch (std::exception&) {
+                return fail("Invalid seed: '" + value + "'");
+            }
+        } else if (arg == "-o") {
+            result.outputFile = value;
+        } else if (arg == "--mix") {
+            std::string error;
+            if (!parseMix(value, result.config.weights, error)) {
+                return fail(error);
+            }
+        } else if (arg == "--live") {
+            long long live = 0;
+            if (!parseCount(value, live) || live > 100000) {
+                return fail("Invalid --live: '" + value + "' (1 to 100000)");
+            }
+            result.config.liveValues = (int)live;
+        } else {
+            double p = 0.0;
+            if (!parseProbability(value, p)) {
+                return fail("Invalid " + arg + ": '" + value + "' is not between 0 and 1");
+            }
+            if (arg == "--reuse") result.config.reuse = p;
+            else if (arg == "--comments") result.config.comments = p;
+            else result.config.depth = p;
+        }
+    }
+
+    return result;
+}
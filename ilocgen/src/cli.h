@@ -0,0 +1,20 @@
+#pragma once
+
+#include "generator.h"
+#include <string>
+
+enum Mode {
+    MODE_HELP,
+    MODE_GENERATE,
+};
+
+struct CLIOptions {
+    Mode mode;
+    GeneratorConfig config;
+    std::string outputFile; // -o <file>; empty = stdout
+    bool valid;
+    std::string errorMessage;
+};
+
+CLIOptions parse_arguments(int argc, char* argv[]);
+void print_help();
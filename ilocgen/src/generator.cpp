@@ -0,0 +1,205 @@
+#include "generator.h"
+#include <charconv>
+#include <utility>
+
+Generator::Generator(const GeneratorConfig& config, std::ostream& out)
+    : config(config), out(out), state(config.seed), totalWeight(0),
+      oldest(0), nextFresh(0), emitted(0) {
+    for (int w : config.weights) {
+        totalWeight += w;
+    }
+    buffer.reserve(FLUSH_AT + 256);
+    window.reserve(config.liveValues);
+}
+
+const char* Generator::opcodeName(int opcode) {
+    switch (opcode) {
+        case GEN_LOADI: return "loadI";
+        case GEN_LOAD: return "load";
+        case GEN_STORE: return "store";
+        case GEN_ADD: return "add";
+        case GEN_SUB: return "sub";
+        case GEN_MULT: return "mult";
+        case GEN_LSHIFT: return "lshift";
+        case GEN_RSHIFT: return "rshift";
+        case GEN_OUTPUT: return "output";
+        case GEN_NOP: return "nop";
+        default: return "";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Randomness — splitmix64 rather than <random>, whose distributions differ
+// between standard libraries; a seed names the same file everywhere.
+// ---------------------------------------------------------------------------
+uint64_t Generator::next() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint64_t Generator::below(uint64_t n) {
+    return next() % n;
+}
+
+bool Generator::chance(double p) {
+    return (next() >> 11) * 0x1.0p-53 < p;
+}
+
+int Generator::pickOpcode() {
+    long long pick = (long long)below(totalWeight);
+    for (int op = 0; op < GEN_OPCODE_COUNT; op++) {
+        pick -= config.weights[op];
+        if (pick < 0) return op;
+    }
+    return GEN_LOADI;
+}
+
+// ---------------------------------------------------------------------------
+// Values and addresses
+// ---------------------------------------------------------------------------
+
+// `depth` decides between the newest value (one long dependence chain) and
+// any live one (many short, independent chains)
+int Generator::source() {
+    size_t count = window.size();
+    size_t newest = (oldest + count - 1) % count;
+    if (chance(config.depth)) return window[newest];
+    return window[(oldest + below(count)) % count];
+}
+
+int Generator::define(int keep) {
+    if ((int)window.size() < config.liveValues) {
+        window.push_back((int)window.size());
+        return window.back();
+    }
+    // `keep` is still to be read; the next oldest dies in its place
+    size_t second = (oldest + 1) % window.size();
+    if (window[oldest] == keep) std::swap(window[oldest], window[second]);
+    int r = window[oldest]; // the oldest value dies; its register holds the newest
+    oldest = (oldest + 1) % window.size();
+    return r;
+}
+
+uint32_t Generator::address() {
+    if (!usedAddresses.empty() && chance(config.reuse)) {
+        return usedAddresses[below(usedAddresses.size())];
+    }
+    uint32_t a = nextFresh;
+    nextFresh = (nextFresh + 4) % ADDRESS_LIMIT;
+    if (usedAddresses.size() < ADDRESS_LIMIT / 4) usedAddresses.push_back(a);
+    return a;
+}
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+void Generator::append(long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, result.ptr);
+}
+
+void Generator::reg(int r) {
+    buffer += 'r';
+    append(r);
+}
+
+// half the comments get a line of their own, before the op
+void Generator::commentLine() {
+    if (config.comments > 0 && chance(config.comments * 0.5)) {
+        buffer += "// op ";
+        append(emitted);
+        buffer += '\n';
+    }
+}
+
+// and half trail it
+void Generator::endOp() {
+    if (config.comments > 0 && chance(config.comments * 0.5)) {
+        buffer += " // op ";
+        append(emitted);
+    }
+    buffer += '\n';
+    emitted++;
+    if (buffer.size() >= FLUSH_AT) flush();
+}
+
+void Generator::flush() {
+    out.write(buffer.data(), (std::streamsize)buffer.size());
+    buffer.clear();
+}
+
+void Generator::run() {
+    while (emitted < config.ops) {
+        int op = pickOpcode();
+        bool memory = (op == GEN_LOAD || op == GEN_STORE);
+
+        // ops that read a value need one; loads and stores need two slots
+        if (window.empty() && op != GEN_OUTPUT && op != GEN_NOP) op = GEN_LOADI;
+        if (memory && config.ops - emitted < 2) op = GEN_LOADI;
+
+        commentLine();
+        switch (op) {
+            case GEN_LOADI: {
+                long long value = (long long)below(1u << 16);
+                int d = define();
+                buffer += "loadI ";
+                append(value);
+                buffer += " => ";
+                reg(d);
+                break;
+            }
+            case GEN_LOAD:
+            case GEN_STORE: {
+                int value = (op == GEN_STORE) ? source() : -1;
+                uint32_t a = address();
+                int base = define(value);
+                buffer += "loadI ";
+                append(a);
+                buffer += " => ";
+                reg(base);
+                endOp();
+                commentLine();
+
+                if (op == GEN_LOAD) {
+                    int d = define();
+                    buffer += "load ";
+                    reg(base);
+                    buffer += " => ";
+                    reg(d);
+                } else {
+                    buffer += "store ";
+                    reg(value);
+                    buffer += " => ";
+                    reg(base);
+                }
+                break;
+            }
+            case GEN_OUTPUT:
+                buffer += "output ";
+                append(address());
+                break;
+            case GEN_NOP:
+                buffer += "nop";
+                break;
+            default: { // arithmetic
+                int a = source();
+                int b = source();
+                int d = define();
+                buffer += opcodeName(op);
+                buffer += ' ';
+                reg(a);
+                buffer += ", ";
+                reg(b);
+                buffer += " => ";
+                reg(d);
+                break;
+            }
+        }
+        endOp();
+    }
+    flush();
+    out.flush();
+}
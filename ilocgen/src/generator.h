@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// opcodes the generator emits; also the order of GeneratorConfig::weights
+enum GenOpcode {
+    GEN_LOADI,
+    GEN_LOAD,
+    GEN_STORE,
+    GEN_ADD,
+    GEN_SUB,
+    GEN_MULT,
+    GEN_LSHIFT,
+    GEN_RSHIFT,
+    GEN_OUTPUT,
+    GEN_NOP,
+    GEN_OPCODE_COUNT
+};
+
+struct GeneratorConfig {
+    long long ops = 1000;       // ops to emit (address loadIs of loads and stores count)
+    uint64_t seed = 1;          // same seed and settings, same file
+    int weights[GEN_OPCODE_COUNT] = {15, 10, 10, 20, 10, 10, 5, 5, 2, 0};
+    int liveValues = 16;        // values readable at once, so MAXLIVE stays near this
+    double reuse = 0.5;         // chance a memory op uses an address used before
+    double comments = 0.0;      // chance an op gets a comment (own line or trailing)
+    double depth = 0.3;         // chance an operand is the value defined just before
+};
+
+// Writes a random but valid ILOC block: every register is defined before it
+// is read, and every address is a word-aligned constant below the spill area
+// the allocators use. Output goes through a fixed buffer, so the size of the
+// block does not change the memory the generator needs.
+class Generator {
+public:
+    Generator(const GeneratorConfig& config, std::ostream& out);
+
+    void run(); // emit config.ops ops
+
+    static const char* opcodeName(int opcode);
+
+private:
+    static constexpr uint32_t ADDRESS_LIMIT = 32768; // first spill address
+    static constexpr size_t FLUSH_AT = 1 << 16;
+
+    const GeneratorConfig& config;
+    std::ostream& out;
+    std::string buffer;
+    uint64_t state; // splitmix64
+    int totalWeight;
+
+    // live values, oldest first, in a ring of config.liveValues registers
+    std::vector<int> window;
+    size_t oldest;
+
+    std::vector<uint32_t> usedAddresses;
+    uint32_t nextFresh;
+    long long emitted;
+
+    uint64_t next();
+    uint64_t below(uint64_t n); // uniform in [0, n)
+    bool chance(double p);
+
+    int pickOpcode();
+    int source(); // register holding a live value
+    int define(int keep = -1); // register for a new value; the oldest value other than keep dies when the ring is full
+    uint32_t address();
+
+    void commentLine();
+    void append(long long value);
+    void reg(int r);
+    void endOp();
+    void flush();
+};
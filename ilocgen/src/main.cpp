@@ -0,0 +1,37 @@
+#include "cli.h"
+#include "generator.h"
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+    CLIOptions options = parse_arguments(argc, argv);
+
+    if (!options.valid) {
+        std::cerr << options.errorMessage << std::endl;
+        return 1;
+    }
+
+    if (options.mode == MODE_HELP) {
+        print_help();
+        return 0;
+    }
+
+    std::ofstream file;
+    if (!options.outputFile.empty()) {
+        file.open(options.outputFile, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << options.outputFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = options.outputFile.empty() ? std::cout : file;
+
+    Generator generator(options.config, out);
+    generator.run();
+
+    if (!out) {
+        std::cerr << "Error: Could not write the generated block" << std::endl;
+        return 1;
+    }
+    return 0;
+}
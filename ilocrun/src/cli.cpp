@@ -0,0 +1,105 @@
+#include "cli.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void print_help() {
+    std::cout << "Usage: ilocrun [option] <name>" << std::endl;
+    std::cout << "       ilocrun --check <original> <transformed>" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -h        Print this help message" << std::endl;
+    std::cout << "  <name>    Run the ILOC block in <name> and print the value of every" << std::endl;
+    std::cout << "            output op, one per line. <name> may hold ILOC text, a" << std::endl;
+    std::cout << "            schedule printed by schedule (one \"[ op ; op ]\" cycle per" << std::endl;
+    std::cout << "            line) or a binary IR file (.ilir)" << std::endl;
+    std::cout << "  --check <original> <transformed>" << std::endl;
+    std::cout << "            Run both blocks and compare their output streams; exit" << std::endl;
+    std::cout << "            with 1 if they differ or either block faults" << std::endl;
+    std::cout << "  --counts  Also print how many ops of each opcode ran and the ops" << std::endl;
+    std::cout << "            per second to stderr" << std::endl;
+    std::cout << "  --jit     Compile each block to x86-64 code and run that instead of" << std::endl;
+    std::cout << "            interpreting it; registers 0 to 8, as after allocation with" << std::endl;
+    std::cout << "            k <= 9, live in host registers" << std::endl;
+    std::cout << "  --repeat <n>" << std::endl;
+    std::cout << "            Run the block <n> times on a clean machine, for timing" << std::endl;
+}
+
+// a whole argument as an int; std::stoi alone takes "10abc" as 10
+static bool parseInt(const std::string& text, int& value) {
+    try {
+        size_t used = 0;
+        value = std::stoi(text, &used);
+        return used == text.size();
+    } catch (std::exception&) {
+        return false;
+    }
+}
+
+CLIOptions parse_arguments(int argc, char* argv[]) {
+    CLIOptions result;
+    result.valid = true;
+    result.mode = MODE_RUN;
+    result.counts = false;
+    result.native = false;
+    result.repeat = 1;
+
+    const std::string usage = "Usage: ilocrun [option] <name>";
+
+    if (argc < 2) {
+        result.valid = false;
+        result.errorMessage = usage;
+        return result;
+    }
+
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h") {
+            result.mode = MODE_HELP;
+            return result;
+        } else if (arg == "--check") {
+            result.mode = MODE_CHECK;
+        } else if (arg == "--counts") {
+            result.counts = true;
+        } else if (arg == "--jit") {
+            result.native = true;
+        } else if (arg == "--repeat") {
+            if (i + 1 >= argc) {
+                result.valid = false;
+                result.errorMessage = "--repeat requires a number of runs";
+                return result;
+            }
+            if (!parseInt(argv[++i], result.repeat)) result.repeat = -1;
+            if (result.repeat <= 0) {
+                result.valid = false;
+                result.errorMessage = "Invalid run count: '" + std::string(argv[i]) + "' is not a positive number.";
+                return result;
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            result.valid = false;
+            result.errorMessage = "Unknown option: " + arg;
+            return result;
+        } else {
+            names.push_back(arg);
+        }
+    }
+
+    if (result.mode == MODE_CHECK) {
+        if (names.size() != 2) {
+            result.valid = false;
+            result.errorMessage = "Usage: ilocrun --check <original> <transformed>";
+            return result;
+        }
+        result.filename = names[0];
+        result.transformedFile = names[1];
+    } else if (names.size() == 1) {
+        result.filename = names[0];
+    } else {
+        result.valid = false;
+        result.errorMessage = usage;
+    }
+
+    return result;
+}
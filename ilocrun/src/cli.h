@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+enum Mode {
+    MODE_HELP,
+    MODE_RUN,
+    MODE_CHECK,
+};
+
+struct CLIOptions {
+    Mode mode;
+    std::string filename;
+    std::string transformedFile; // --check: the block compared against filename
+    bool counts;        // --counts: ops per opcode and ops/sec on stderr
+    bool native;        // --jit: run the block compiled to x86-64 code
+    int repeat;         // --repeat N: run N times, for timing
+    bool valid;
+    std::string errorMessage;
+};
+
+CLIOptions parse_arguments(int argc, char* argv[]);
+void print_help();
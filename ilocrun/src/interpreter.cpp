@@ -0,0 +1,262 @@
+#include "interpreter.h"
+#include <algorithm>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Predecoding
+// ---------------------------------------------------------------------------
+
+static bool readsMemory(const IRNode* op) {
+    return op->opcode == TOKEN_LOAD || op->opcode == TOKEN_OUTPUT;
+}
+
+// the register an op writes, or -1
+static int destinationOf(const IRNode* op) {
+    switch (op->opcode) {
+        case TOKEN_LOADI:
+        case TOKEN_LOAD:
+        case TOKEN_ADD:
+        case TOKEN_SUB:
+        case TOKEN_MULT:
+        case TOKEN_LSHIFT:
+        case TOKEN_RSHIFT:
+            return op->sr3;
+        default:
+            return -1;
+    }
+}
+
+static bool readsRegister(const IRNode* op, int reg) {
+    switch (op->opcode) {
+        case TOKEN_LOAD:
+            return op->sr1 == reg;
+        case TOKEN_STORE:
+            return op->sr1 == reg || op->sr3 == reg;
+        case TOKEN_ADD:
+        case TOKEN_SUB:
+        case TOKEN_MULT:
+        case TOKEN_LSHIFT:
+        case TOKEN_RSHIFT:
+            return op->sr1 == reg || op->sr2 == reg;
+        default:
+            return false;
+    }
+}
+
+Interpreter::Interpreter(const IRNode* head, const std::vector<int>& bundles)
+    : zeroPage(new int32_t[PAGE_WORDS]()) {
+    pages.assign(PAGE_COUNT, zeroPage.get());
+
+    int maxRegister = -1;
+    for (const IRNode* node = head; node; node = node->next) {
+        if (node->opcode == TOKEN_LOADI || node->opcode == TOKEN_OUTPUT) {
+            maxRegister = std::max(maxRegister, node->sr3);
+        } else if (node->opcode != TOKEN_NOP) {
+            maxRegister = std::max({maxRegister, node->sr1, node->sr2, node->sr3});
+        }
+    }
+
+    // cycle results that another op of the cycle still has to read go to
+    // scratch registers past the block's own, numbered from here
+    int scratch = maxRegister + 1;
+    std::vector<const IRNode*> bundle;
+    size_t index = 0;
+    for (const IRNode* node = head; node; node = node->next, index++) {
+        bool sameCycle = !bundle.empty() && index < bundles.size() && bundles[index] == bundles[index - 1];
+        if (!sameCycle && !bundle.empty()) {
+            decodeBundle(bundle, scratch);
+            bundle.clear();
+        }
+        bundle.push_back(node);
+    }
+    if (!bundle.empty()) decodeBundle(bundle, scratch);
+    emit(H_HALT, 0, 0, 0);
+
+    registers.assign(scratch, 0);
+}
+
+Interpreter::~Interpreter() {
+    releaseNative();
+}
+
+void Interpreter::emit(int32_t handler, int32_t a, int32_t b, int32_t c) {
+    // the fused op never faults: the address is a constant, checked here
+    Instruction* last = code.empty() ? nullptr : &code.back();
+    if (last && last->handler == H_LOADI && (last->a & 3) == 0) {
+        int32_t address = last->a, reg = last->c;
+        if (handler == H_LOAD && a == reg) {
+            *last = {H_LOADI_LOAD, address, reg, c};
+            return;
+        }
+        if (handler == H_STORE && c == reg) {
+            *last = {H_LOADI_STORE, a, reg, address};
+            return;
+        }
+    }
+    code.push_back({handler, a, b, c});
+    finishedBefore.push_back((uint32_t)executed.size());
+}
+
+// one cycle: loads and outputs go before a store so they see the old word,
+// and a result that a later op of the cycle reads is held in a scratch
+// register and copied once the whole cycle has run
+void Interpreter::decodeBundle(const std::vector<const IRNode*>& bundle, int& scratch) {
+    std::vector<const IRNode*> order(bundle);
+    if (order.size() > 1) std::stable_partition(order.begin(), order.end(), readsMemory);
+
+    std::vector<std::pair<int32_t, int32_t>> copies;   // scratch, destination
+    for (size_t i = 0; i < order.size(); i++) {
+        const IRNode* op = order[i];
+        int32_t destination = destinationOf(op);
+        for (size_t j = i + 1; destination >= 0 && j < order.size(); j++) {
+            if (readsRegister(order[j], destination)) {
+                copies.push_back({scratch, destination});
+                destination = scratch++;
+                break;
+            }
+        }
+
+        switch (op->opcode) {
+            case TOKEN_LOADI:  emit(H_LOADI, op->sr1, 0, destination); break;
+            case TOKEN_LOAD:   emit(H_LOAD, op->sr1, 0, destination); break;
+            case TOKEN_STORE:  emit(H_STORE, op->sr1, 0, op->sr3); break;
+            case TOKEN_ADD:    emit(H_ADD, op->sr1, op->sr2, destination); break;
+            case TOKEN_SUB:    emit(H_SUB, op->sr1, op->sr2, destination); break;
+            case TOKEN_MULT:   emit(H_MULT, op->sr1, op->sr2, destination); break;
+            case TOKEN_LSHIFT: emit(H_LSHIFT, op->sr1, op->sr2, destination); break;
+            case TOKEN_RSHIFT: emit(H_RSHIFT, op->sr1, op->sr2, destination); break;
+            case TOKEN_OUTPUT: emit(H_OUTPUT, op->sr1, 0, 0); break;
+            default: break;   // nop
+        }
+        executed.push_back((uint8_t)op->opcode);
+    }
+    for (const auto& [from, to] : copies) emit(H_COPY, from, 0, to);
+}
+
+// ---------------------------------------------------------------------------
+// Execution
+// ---------------------------------------------------------------------------
+
+int32_t* Interpreter::touchPage(uint32_t word) {
+    ownedPages.emplace_back(new int32_t[PAGE_WORDS]());
+    pages[word / PAGE_WORDS] = ownedPages.back().get();
+    return ownedPages.back().get();
+}
+
+// pages already touched stay mapped for the next run
+void Interpreter::reset() {
+    std::fill(registers.begin(), registers.end(), 0);
+    for (const auto& page : ownedPages)
+        std::memset(page.get(), 0, PAGE_WORDS * sizeof(int32_t));
+}
+
+void Interpreter::count(RunReport& report, size_t instruction) const {
+    report.ops = finishedBefore[instruction];
+    for (size_t i = 0; i < report.ops; i++) report.counts[executed[i]]++;
+}
+
+RunReport Interpreter::run() {
+    // handler offsets from h_loadI, in Handler order
+#define OFFSET(label) (int32_t)((const char*)&&label - (const char*)&&h_loadI)
+    static const int32_t offsets[HANDLER_COUNT] = {
+        OFFSET(h_loadI), OFFSET(h_load), OFFSET(h_store), OFFSET(h_add), OFFSET(h_sub),
+        OFFSET(h_mult), OFFSET(h_lshift), OFFSET(h_rshift), OFFSET(h_output), OFFSET(h_copy),
+        OFFSET(h_halt), OFFSET(h_loadI_load), OFFSET(h_loadI_store),
+    };
+#undef OFFSET
+    if (threadedCode.empty()) {
+        threadedCode = code;
+        for (Instruction& instruction : threadedCode) instruction.handler = offsets[instruction.handler];
+    }
+    reset();
+
+    RunReport report;
+    const char* base = static_cast<const char*>(&&h_loadI);
+    const Instruction* ip = threadedCode.data();
+    int32_t* r = registers.data();
+    int32_t* const* page = pages.data();
+    const int32_t* zero = zeroPage.get();
+    uint32_t address = 0;
+
+#define DISPATCH() goto *(base + ip->handler)
+#define WORD(address) page[(address) >> 12][((address) >> 2) & (PAGE_WORDS - 1)]
+
+    DISPATCH();
+
+h_loadI:
+    r[ip->c] = ip->a;
+    ip++;
+    DISPATCH();
+h_load:
+    address = (uint32_t)r[ip->a];
+    if (address & 3) goto fault;
+    r[ip->c] = WORD(address);
+    ip++;
+    DISPATCH();
+h_store: {
+    address = (uint32_t)r[ip->c];
+    if (address & 3) goto fault;
+    int32_t* words = page[address >> 12];
+    if (words == zero) words = touchPage(address >> 2);
+    words[(address >> 2) & (PAGE_WORDS - 1)] = r[ip->a];
+    ip++;
+    DISPATCH();
+}
+h_add:
+    r[ip->c] = (int32_t)((uint32_t)r[ip->a] + (uint32_t)r[ip->b]);
+    ip++;
+    DISPATCH();
+h_sub:
+    r[ip->c] = (int32_t)((uint32_t)r[ip->a] - (uint32_t)r[ip->b]);
+    ip++;
+    DISPATCH();
+h_mult:
+    r[ip->c] = (int32_t)((uint32_t)r[ip->a] * (uint32_t)r[ip->b]);
+    ip++;
+    DISPATCH();
+h_lshift: {
+    int32_t n = r[ip->b];
+    r[ip->c] = (n < 0 || n > 31) ? 0 : (int32_t)((uint32_t)r[ip->a] << n);
+    ip++;
+    DISPATCH();
+}
+h_rshift: {
+    int32_t x = r[ip->a], n = r[ip->b];
+    r[ip->c] = (n < 0 || n > 31) ? (x < 0 ? -1 : 0) : x >> n;
+    ip++;
+    DISPATCH();
+}
+h_output:
+    address = (uint32_t)ip->a;
+    if (address & 3) goto fault;
+    report.output.push_back(WORD(address));
+    ip++;
+    DISPATCH();
+h_copy:
+    r[ip->c] = r[ip->a];
+    ip++;
+    DISPATCH();
+h_loadI_load:
+    r[ip->b] = ip->a;
+    r[ip->c] = WORD((uint32_t)ip->a);
+    ip++;
+    DISPATCH();
+h_loadI_store: {
+    r[ip->b] = ip->c;
+    uint32_t word = (uint32_t)ip->c >> 2;
+    int32_t* words = page[word / PAGE_WORDS];
+    if (words == zero) words = touchPage(word);
+    words[word & (PAGE_WORDS - 1)] = r[ip->a];
+    ip++;
+    DISPATCH();
+}
+fault:
+    report.ok = false;
+    report.error = "memory access at invalid address " + std::to_string((int32_t)address);
+h_halt:
+    count(report, ip - threadedCode.data());
+    return report;
+
+#undef WORD
+#undef DISPATCH
+}
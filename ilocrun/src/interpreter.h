@@ -0,0 +1,96 @@
+#pragma once
+
+#include "parser.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Outcome of one run
+struct RunReport {
+    bool ok = true;                  // ran to the end without a fault
+    std::string error;               // first fault, when !ok
+    std::vector<int32_t> output;     // values printed by output ops, in order
+    uint64_t ops = 0;                // ILOC ops executed, nops included
+    uint64_t counts[TOKEN_NOP + 1] = {};  // ops executed per opcode
+};
+
+// Runs ILOC blocks fast enough to check transformed code at scale. The block
+// is predecoded once into 16-byte instructions whose first field is the
+// offset of their handler, and run() dispatches with computed gotos (a GCC
+// and Clang extension). A loadI of an address fuses with the load or store
+// that uses it, which saves a dispatch and the alignment check. Registers
+// are a flat array; memory is 32-bit words in 4 KB pages allocated on the
+// first store, so any aligned address works.
+//
+// compileNative() and runNative() run the same predecoded block as x86-64
+// code instead, with the same results and counts (jit.cpp).
+class Interpreter {
+public:
+    // bundles[i], when given, is the issue cycle of op i of a schedule: the
+    // ops of one cycle all read their operands before any of them writes
+    explicit Interpreter(const IRNode* head, const std::vector<int>& bundles = {});
+    ~Interpreter();
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    // run from a clean machine: registers and memory zero
+    RunReport run();
+
+    // compile the block to x86-64 code in an executable mapping (jit.cpp);
+    // false, with the reason in error, where that cannot be done
+    bool compileNative(std::string& error);
+
+    // run the compiled block from a clean machine; compileNative first
+    RunReport runNative();
+
+private:
+    enum Handler : int32_t {
+        H_LOADI, H_LOAD, H_STORE, H_ADD, H_SUB, H_MULT, H_LSHIFT, H_RSHIFT,
+        H_OUTPUT, H_COPY, H_HALT,
+        H_LOADI_LOAD, H_LOADI_STORE,   // loadI of an aligned address and the op using it
+        HANDLER_COUNT
+    };
+
+    // a = source or immediate, b = second source, c = destination (the
+    // address register for store)
+    struct Instruction {
+        int32_t handler;   // a Handler; in threadedCode, its offset
+        int32_t a, b, c;
+    };
+
+    // the native block; returns -1, or for a fault the instruction index
+    // in the high and the address in the low 32 bits
+    using NativeBlock = int64_t (*)(int32_t* frame, char* memory, int32_t* output);
+
+    static constexpr uint32_t PAGE_WORDS = 1024;
+    static constexpr uint32_t PAGE_COUNT = 1u << 20;   // 2^30 words
+
+    std::vector<Instruction> code;
+    std::vector<Instruction> threadedCode;   // built by the first run()
+    std::vector<int32_t> registers;
+
+    // the ILOC opcode of each op in execution order, and for every
+    // instruction the number of those ops finished before it; a fault
+    // only needs these to count what ran
+    std::vector<uint8_t> executed;
+    std::vector<uint32_t> finishedBefore;
+
+    std::vector<int32_t*> pages;   // zeroPage until a store touches the page
+    std::vector<std::unique_ptr<int32_t[]>> ownedPages;
+    std::unique_ptr<int32_t[]> zeroPage;
+
+    // native backend: code and a 4 GB reservation for memory, whose pages
+    // the kernel hands out zeroed on first touch
+    NativeBlock nativeCode = nullptr;
+    size_t nativeCodeSize = 0;
+    char* nativeMemory = nullptr;
+    std::vector<int32_t> nativeOutput;
+
+    void decodeBundle(const std::vector<const IRNode*>& bundle, int& scratch);
+    void emit(int32_t handler, int32_t a, int32_t b, int32_t c);
+    int32_t* touchPage(uint32_t word);
+    void reset();
+    void count(RunReport& report, size_t instruction) const;
+    void releaseNative();
+};
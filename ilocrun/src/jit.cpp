@@ -0,0 +1,278 @@
+// The native backend of Interpreter: the predecoded block compiled to
+// x86-64 code. ILOC registers 0..8 live in host registers, the rest in a
+// frame; memory is a 4 GB reservation indexed by the ILOC address, and
+// output ops append to a buffer sized for every output op of the block.
+// Faults leave through out-of-line stubs, so a block that runs clean takes
+// no branch but the alignment checks.
+
+#include "interpreter.h"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <vector>
+#include <sys/mman.h>
+
+static constexpr uint64_t NATIVE_MEMORY_BYTES = 1ull << 32;
+
+#if defined(__x86_64__)
+
+namespace {
+
+// x86-64 register numbers
+enum HostRegister {
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+    R8 = 8, R9, R10, R11, R12, R13, R14, R15,
+};
+
+// rax, rcx and rdx are scratch; rdi holds the frame, rsi memory and r8 the
+// output buffer; these hold ILOC registers 0..8
+constexpr HostRegister HOSTED[] = {RBX, RBP, R9, R10, R11, R12, R13, R14, R15};
+constexpr int HOSTED_COUNT = sizeof HOSTED / sizeof HOSTED[0];
+constexpr HostRegister CALLEE_SAVED[] = {RBX, RBP, R12, R13, R14, R15};
+
+class Assembler {
+public:
+    std::vector<uint8_t> bytes;
+
+    void byte(uint8_t b) { bytes.push_back(b); }
+    void bytesOf(std::initializer_list<uint8_t> list) { bytes.insert(bytes.end(), list); }
+    void dword(uint32_t value) {
+        for (int i = 0; i < 4; i++) byte((uint8_t)(value >> (8 * i)));
+    }
+    size_t here() const { return bytes.size(); }
+
+    // a rel32 whose target is set later
+    size_t rel32() {
+        dword(0);
+        return here() - 4;
+    }
+    void bind(size_t at, size_t target) {
+        int32_t offset = (int32_t)(target - (at + 4));
+        std::memcpy(&bytes[at], &offset, 4);
+    }
+
+    void rex(bool wide, int reg, int rm) {
+        uint8_t prefix = 0x40 | (wide << 3) | ((reg >> 3) << 2) | (rm >> 3);
+        if (prefix != 0x40) byte(prefix);
+    }
+
+    // opcode with a 32-bit register and ILOC register operand: the host
+    // register it lives in, or its frame slot [rdi + 4 * iloc]
+    void withIloc(std::initializer_list<uint8_t> opcode, int reg, int32_t iloc) {
+        if (iloc < HOSTED_COUNT) {
+            int host = HOSTED[iloc];
+            rex(false, reg, host);
+            bytesOf(opcode);
+            byte(0xC0 | (reg & 7) << 3 | (host & 7));
+        } else {
+            rex(false, reg, RDI);
+            bytesOf(opcode);
+            byte(0x80 | (reg & 7) << 3 | RDI);
+            dword((uint32_t)iloc * 4);
+        }
+    }
+
+    void load(int reg, int32_t iloc) { withIloc({0x8B}, reg, iloc); }    // mov reg, iloc
+    void store(int reg, int32_t iloc) { withIloc({0x89}, reg, iloc); }   // mov iloc, reg
+    void loadImmediate(int32_t iloc, int32_t value) {                    // mov iloc, imm32
+        withIloc({0xC7}, 0, iloc);
+        dword((uint32_t)value);
+    }
+};
+
+} // namespace
+
+bool Interpreter::compileNative(std::string& error) {
+    if (nativeCode) return true;
+    if (registers.size() >= (1u << 29)) {
+        error = "too many registers for the native frame";
+        return false;
+    }
+
+    Assembler as;
+    for (HostRegister reg : CALLEE_SAVED) {   // push
+        as.rex(false, 0, reg);
+        as.byte(0x50 | (reg & 7));
+    }
+    as.bytesOf({0x49, 0x89, 0xD0});           // mov r8, rdx
+    for (HostRegister reg : HOSTED) {         // xor reg, reg
+        as.rex(false, reg, reg);
+        as.byte(0x31);
+        as.byte(0xC0 | (reg & 7) << 3 | (reg & 7));
+    }
+
+    // jumps to the fault stub of each instruction that can fault
+    std::vector<std::pair<size_t, uint32_t>> faults;
+    auto jumpToFault = [&](bool conditional, uint32_t index) {
+        if (conditional) as.bytesOf({0x0F, 0x85});   // jnz
+        else as.byte(0xE9);                          // jmp
+        faults.push_back({as.rel32(), index});
+    };
+    auto checkAligned = [&](uint32_t index) {
+        as.bytesOf({0xA9, 0x03, 0x00, 0x00, 0x00});  // test eax, 3
+        jumpToFault(true, index);
+    };
+
+    size_t outputs = 0;
+    for (uint32_t index = 0; index < code.size(); index++) {
+        const Instruction& in = code[index];
+        switch (in.handler) {
+            case H_LOADI:
+                as.loadImmediate(in.c, in.a);
+                break;
+            case H_LOAD:
+                as.load(RAX, in.a);
+                checkAligned(index);
+                as.bytesOf({0x8B, 0x04, 0x06});      // mov eax, [rsi + rax]
+                as.store(RAX, in.c);
+                break;
+            case H_STORE:
+                as.load(RAX, in.c);
+                checkAligned(index);
+                as.load(RDX, in.a);
+                as.bytesOf({0x89, 0x14, 0x06});      // mov [rsi + rax], edx
+                break;
+            case H_ADD:
+            case H_SUB:
+            case H_MULT:
+                as.load(RAX, in.a);
+                if (in.handler == H_ADD) as.withIloc({0x03}, RAX, in.b);
+                else if (in.handler == H_SUB) as.withIloc({0x2B}, RAX, in.b);
+                else as.withIloc({0x0F, 0xAF}, RAX, in.b);
+                as.store(RAX, in.c);
+                break;
+            case H_LSHIFT:
+                // x86 masks the count to 5 bits; ILOC shifts everything out
+                as.load(RAX, in.a);
+                as.load(RCX, in.b);
+                as.bytesOf({0xD3, 0xE0});            // shl eax, cl
+                as.bytesOf({0x31, 0xD2});            // xor edx, edx
+                as.bytesOf({0x83, 0xF9, 0x1F});      // cmp ecx, 31
+                as.bytesOf({0x0F, 0x47, 0xC2});      // cmova eax, edx
+                as.store(RAX, in.c);
+                break;
+            case H_RSHIFT:
+                // any count past 31 gives the sign, as a shift by 31 does
+                as.load(RAX, in.a);
+                as.load(RCX, in.b);
+                as.bytesOf({0xBA, 0x1F, 0x00, 0x00, 0x00});  // mov edx, 31
+                as.bytesOf({0x83, 0xF9, 0x1F});      // cmp ecx, 31
+                as.bytesOf({0x0F, 0x47, 0xCA});      // cmova ecx, edx
+                as.bytesOf({0xD3, 0xF8});            // sar eax, cl
+                as.store(RAX, in.c);
+                break;
+            case H_OUTPUT:
+                if (in.a & 3) {
+                    as.byte(0xB8);                   // mov eax, address
+                    as.dword((uint32_t)in.a);
+                    jumpToFault(false, index);
+                    break;
+                }
+                as.bytesOf({0x8B, 0x86});            // mov eax, [rsi + address]
+                as.dword((uint32_t)in.a);
+                as.bytesOf({0x41, 0x89, 0x00});      // mov [r8], eax
+                as.bytesOf({0x49, 0x83, 0xC0, 0x04}); // add r8, 4
+                outputs++;
+                break;
+            case H_COPY:
+                as.load(RAX, in.a);
+                as.store(RAX, in.c);
+                break;
+            case H_LOADI_LOAD:
+                as.loadImmediate(in.b, in.a);
+                as.bytesOf({0x8B, 0x86});            // mov eax, [rsi + address]
+                as.dword((uint32_t)in.a);
+                as.store(RAX, in.c);
+                break;
+            case H_LOADI_STORE:
+                as.loadImmediate(in.b, in.c);
+                as.load(RDX, in.a);
+                as.bytesOf({0x89, 0x96});            // mov [rsi + address], edx
+                as.dword((uint32_t)in.c);
+                break;
+            case H_HALT:
+                as.bytesOf({0x48, 0xC7, 0xC0, 0xFF, 0xFF, 0xFF, 0xFF});  // mov rax, -1
+                break;
+        }
+    }
+
+    size_t epilogue = as.here();
+    for (auto reg = std::rbegin(CALLEE_SAVED); reg != std::rend(CALLEE_SAVED); ++reg) {  // pop
+        as.rex(false, 0, *reg);
+        as.byte(0x58 | (*reg & 7));
+    }
+    as.byte(0xC3);                                   // ret
+
+    // a stub per faulting instruction: rax = index << 32 | address
+    for (const auto& [jump, index] : faults) {
+        as.bind(jump, as.here());
+        as.byte(0xBA);                               // mov edx, index
+        as.dword(index);
+        as.bytesOf({0x48, 0xC1, 0xE2, 0x20});        // shl rdx, 32
+        as.bytesOf({0x48, 0x09, 0xD0});              // or rax, rdx
+        as.byte(0xE9);                               // jmp epilogue
+        as.bind(as.rel32(), epilogue);
+    }
+
+    void* text = mmap(nullptr, as.bytes.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (text == MAP_FAILED) {
+        error = "cannot map memory for the native code";
+        return false;
+    }
+    std::memcpy(text, as.bytes.data(), as.bytes.size());
+    if (mprotect(text, as.bytes.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(text, as.bytes.size());
+        error = "cannot make the native code executable";
+        return false;
+    }
+
+    void* memory = mmap(nullptr, NATIVE_MEMORY_BYTES, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) {
+        munmap(text, as.bytes.size());
+        error = "cannot reserve 4 GB of address space for ILOC memory";
+        return false;
+    }
+
+    nativeCode = reinterpret_cast<NativeBlock>(text);
+    nativeCodeSize = as.bytes.size();
+    nativeMemory = static_cast<char*>(memory);
+    nativeOutput.assign(outputs + 1, 0);
+    return true;
+}
+
+#else
+
+bool Interpreter::compileNative(std::string& error) {
+    error = "the native backend needs an x86-64 host";
+    return false;
+}
+
+#endif
+
+RunReport Interpreter::runNative() {
+    std::fill(registers.begin(), registers.end(), 0);
+    // drop every page the last run touched; they come back zeroed
+    madvise(nativeMemory, NATIVE_MEMORY_BYTES, MADV_DONTNEED);
+
+    int64_t result = nativeCode(registers.data(), nativeMemory, nativeOutput.data());
+
+    RunReport report;
+    size_t end = code.size() - 1;   // the halt
+    if (result != -1) {
+        end = (size_t)((uint64_t)result >> 32);
+        report.ok = false;
+        report.error = "memory access at invalid address " + std::to_string((int32_t)(uint32_t)result);
+    }
+    count(report, end);
+    report.output.assign(nativeOutput.begin(), nativeOutput.begin() + report.counts[TOKEN_OUTPUT]);
+    return report;
+}
+
+void Interpreter::releaseNative() {
+    if (nativeCode) munmap(reinterpret_cast<void*>(nativeCode), nativeCodeSize);
+    if (nativeMemory) munmap(nativeMemory, NATIVE_MEMORY_BYTES);
+    nativeCode = nullptr;
+    nativeMemory = nullptr;
+}
@@ -0,0 +1,208 @@
+#include "cli.h"
+#include "interpreter.h"
+#include "irfile.h"
+#include "parser.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static const char* const OPCODE_NAMES[TOKEN_NOP + 1] = {
+    "load", "loadI", "store", "add", "sub", "mult", "lshift", "rshift", "output", "nop",
+};
+
+static void freeIR(IRNode* head) {
+    while (head) {
+        IRNode* next = head->next;
+        delete head;
+        head = next;
+    }
+}
+
+// a schedule holds one cycle per line, "[ op ; op ]"; put each op on a line
+// of its own and record, for every new line, the line its cycle was on
+static std::string unbundle(const std::string& text, std::vector<int>& cycleOfLine, bool& bundled) {
+    std::string out;
+    out.reserve(text.size());
+    cycleOfLine.assign(1, 0);   // lines count from 1
+    bundled = false;
+
+    int line = 0;
+    for (size_t start = 0; start < text.size(); ) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) end = text.size();
+        line++;
+
+        std::string_view source(text.data() + start, end - start);
+        size_t comment = source.find("//");
+        std::string_view code = source.substr(0, comment);
+        if (code.find('[') == std::string_view::npos) {
+            out.append(source);
+            out += '\n';
+            cycleOfLine.push_back(line);
+        } else {
+            bundled = true;
+            for (char c : code) {
+                if (c == '[' || c == ']') continue;
+                if (c == ';') {
+                    out += '\n';
+                    cycleOfLine.push_back(line);
+                } else {
+                    out += c;
+                }
+            }
+            out += '\n';
+            cycleOfLine.push_back(line);
+        }
+        start = end + 1;
+    }
+    return out;
+}
+
+// parse or map `path`; cycles is filled in for a schedule only
+static IRNode* loadBlock(const std::string& path, std::vector<int>& cycles, bool& ok) {
+    ok = false;
+    cycles.clear();
+    if (IRFile::isIRFile(path)) {
+        IRFile file(path);
+        if (!file.ok()) {
+            std::cerr << "Error: " << file.error() << std::endl;
+            return nullptr;
+        }
+        ok = true;
+        return file.toList();
+    }
+
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open()) {
+        std::cerr << "Error: Could not open file " << path << std::endl;
+        return nullptr;
+    }
+    std::ostringstream contents;
+    contents << input.rdbuf();
+
+    std::vector<int> cycleOfLine;
+    bool bundled = false;
+    std::string text = unbundle(contents.str(), cycleOfLine, bundled);
+
+    Scanner scanner(text.data(), text.size());
+    Parser parser(scanner);
+    parser.setDiagnostics(std::cerr);
+    IRNode* head = parser.parseAll();
+    if (parser.hasErrors()) {
+        freeIR(head);
+        return nullptr;
+    }
+    if (bundled) {
+        for (IRNode* node = head; node; node = node->next)
+            cycles.push_back(cycleOfLine[node->line]);
+    }
+    ok = true;
+    return head;
+}
+
+// run the block in path `repeat` times; the report is that of the last run
+static bool runFile(const std::string& path, const CLIOptions& options, RunReport& report) {
+    std::vector<int> cycles;
+    bool ok = false;
+    IRNode* head = loadBlock(path, cycles, ok);
+    if (!ok) return false;
+    Interpreter interpreter(head, cycles);
+    freeIR(head);
+
+    std::string error;
+    if (options.native && !interpreter.compileNative(error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.repeat; i++)
+        report = options.native ? interpreter.runNative() : interpreter.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (options.counts) {
+        std::fprintf(stderr, "%s%s: %llu ops", path.c_str(), options.native ? " (jit)" : "",
+                     (unsigned long long)report.ops);
+        if (options.repeat > 1) std::fprintf(stderr, " x %d runs", options.repeat);
+        std::fprintf(stderr, " in %.3f ms, %.1f M ops/sec\n", seconds * 1e3,
+                     seconds > 0 ? report.ops * (double)options.repeat / seconds / 1e6 : 0.0);
+        for (int op = 0; op <= TOKEN_NOP; op++) {
+            if (report.counts[op])
+                std::fprintf(stderr, "  %-8s %12llu\n", OPCODE_NAMES[op], (unsigned long long)report.counts[op]);
+        }
+    }
+    return true;
+}
+
+static int runBlock(const CLIOptions& options) {
+    RunReport report;
+    if (!runFile(options.filename, options, report)) return 1;
+
+    std::string out;
+    for (int32_t value : report.output) {
+        out += std::to_string(value);
+        out += '\n';
+    }
+    std::cout << out << std::flush;
+
+    if (!report.ok) {
+        std::cerr << "Error: " << report.error << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// --check: the transformed block must print what the original prints
+static int checkBlocks(const CLIOptions& options) {
+    RunReport original, transformed;
+    if (!runFile(options.filename, options, original) ||
+        !runFile(options.transformedFile, options, transformed))
+        return 1;
+
+    std::cout << "original:    " << original.ops << " ops, "
+              << original.output.size() << " output values" << std::endl;
+    if (!original.ok) {
+        std::cout << "original block faulted: " << original.error << std::endl;
+        return 1;
+    }
+    std::cout << "transformed: " << transformed.ops << " ops, "
+              << transformed.output.size() << " output values" << std::endl;
+    if (!transformed.ok) {
+        std::cout << "transformed block faulted: " << transformed.error << std::endl;
+        return 1;
+    }
+
+    if (transformed.output != original.output) {
+        size_t i = 0;
+        while (i < original.output.size() && i < transformed.output.size() &&
+               original.output[i] == transformed.output[i])
+            i++;
+        std::cout << "output streams differ at value " << i + 1 << std::endl;
+        std::cout << "FAIL" << std::endl;
+        return 1;
+    }
+    std::cout << "output streams match" << std::endl;
+    std::cout << "PASS" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    CLIOptions options = parse_arguments(argc, argv);
+
+    if (!options.valid) {
+        std::cerr << options.errorMessage << std::endl;
+        return 1;
+    }
+
+    if (options.mode == MODE_HELP) {
+        print_help();
+        return 0;
+    }
+
+    return options.mode == MODE_CHECK ? checkBlocks(options) : runBlock(options);
+}
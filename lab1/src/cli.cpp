@@ -8,12 +8,20 @@ void print_help() {
 	std::cout << "  -s <name> Scan the input and print tokens" << std::endl;
 	std::cout << "  -p <name> Scan and parse the input (default)" << std::endl;
 	std::cout << "  -r <name> Scan, parse, and print intermediate representation" << std::endl;
+	std::cout << "  --emit-ir <file>" << std::endl;
+	std::cout << "            With -p or -r, also write the parsed block to <file> as" << std::endl;
+	std::cout << "            binary IR, which 434alloc and schedule read without parsing" << std::endl;
+	std::cout << "  --stats[=json]" << std::endl;
+	std::cout << "            Also print wall and CPU time, allocations and peak RSS" << std::endl;
+	std::cout << "            for each phase to stderr, as a table or as JSON" << std::endl;
 }
 
 CLIOptions parse_arguments(int argc, char* argv[]) {
     CLIOptions result;
     result.mode = MODE_PARSE; //default mode
     result.valid = true;
+    result.stats = false;
+    result.statsJson = false;
 
     std::vector<std::string> flags_found;
     bool has_filename = false;
@@ -30,6 +38,16 @@ CLIOptions parse_arguments(int argc, char* argv[]) {
                 result.filename = argv[++i];
                 has_filename = true;
             }
+        } else if (arg == "--emit-ir") {
+            if (i + 1 >= argc) {
+                result.valid = false;
+                result.errorMessage = "--emit-ir requires an output file name";
+                return result;
+            }
+            result.irFile = argv[++i];
+        } else if (arg == "--stats" || arg == "--stats=json") {
+            result.stats = true;
+            result.statsJson = (arg == "--stats=json");
         } else if (arg[0] != '-') {
             // no flags, just filename
             if (result.filename.empty()) {
@@ -13,6 +13,9 @@ enum Mode {
 struct CLIOptions {
     Mode mode;
     std::string filename;
+    std::string irFile;   // --emit-ir <file>: also write the parsed block as binary IR
+    bool stats;       // --stats: per-phase time and memory on stderr
+    bool statsJson;   // --stats=json: the same as one JSON object
     bool valid;
     std::string errorMessage;
 };
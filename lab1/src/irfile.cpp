@@ -0,0 +1,269 @@
+#include "irfile.h"
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+bool writeIRFile(const std::string& path, const IRNode* head, bool renamed,
+                 const std::string& sourceFile, std::string& error) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        error = "Could not open file " + path;
+        return false;
+    }
+
+    size_t count = 0;
+    for (const IRNode* node = head; node; node = node->next) count++;
+
+    // where each source line starts, to copy out the line of every op
+    std::string text;
+    std::vector<size_t> lineStart;
+    if (!sourceFile.empty()) {
+        std::ifstream source(sourceFile, std::ios::binary | std::ios::ate);
+        if (!source.is_open()) {
+            error = "Could not open file " + sourceFile;
+            return false;
+        }
+        text.resize(source.tellg());
+        source.seekg(0);
+        source.read(&text[0], text.size());
+        lineStart.push_back(0);
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '\n') lineStart.push_back(i + 1);
+        }
+    }
+
+    IRFileHeader header = {};
+    std::memcpy(header.magic, IR_FILE_MAGIC, sizeof header.magic);
+    header.version = IR_FILE_VERSION;
+    header.flags = (renamed ? IR_FILE_RENAMED : 0) | (sourceFile.empty() ? 0 : IR_FILE_LINES);
+    header.recordSize = sizeof(IRRecord);
+    header.count = count;
+    header.linesOffset = sourceFile.empty() ? 0 : sizeof(IRFileHeader) + count * sizeof(IRRecord);
+    out.write(reinterpret_cast<const char*>(&header), sizeof header);
+
+    // records in batches, so a large block never needs a second copy in memory
+    std::vector<IRRecord> batch;
+    batch.reserve(4096);
+    auto flush = [&]() {
+        out.write(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(IRRecord));
+        batch.clear();
+    };
+    for (const IRNode* node = head; node; node = node->next) {
+        batch.push_back({(uint32_t)node->opcode, node->line,
+                         node->sr1, node->sr2, node->sr3,
+                         node->vr1, node->vr2, node->vr3});
+        if (batch.size() == batch.capacity()) flush();
+    }
+    flush();
+
+    if (!sourceFile.empty()) {
+        auto lineOf = [&](int line, size_t& begin, size_t& end) {
+            begin = end = 0;
+            if (line < 1 || (size_t)line > lineStart.size()) return;
+            begin = lineStart[line - 1];
+            end = (size_t)line < lineStart.size() ? lineStart[line] - 1 : text.size();
+            if (end > begin && text[end - 1] == '\r') end--;
+        };
+
+        std::vector<uint32_t> offsets;
+        offsets.reserve(count + 1);
+        uint32_t offset = 0;
+        for (const IRNode* node = head; node; node = node->next) {
+            size_t begin, end;
+            lineOf(node->line, begin, end);
+            offsets.push_back(offset);
+            if (offset + (end - begin) > UINT32_MAX) {
+                error = "Source lines too long for the line table";
+                return false;
+            }
+            offset += (uint32_t)(end - begin);
+        }
+        offsets.push_back(offset);
+        out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+
+        for (const IRNode* node = head; node; node = node->next) {
+            size_t begin, end;
+            lineOf(node->line, begin, end);
+            out.write(text.data() + begin, end - begin);
+        }
+    }
+
+    if (!out) {
+        error = "Could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool IRFile::isIRFile(const std::string& path) {
+    // only a regular file can be read twice; the bytes checked here would
+    // be gone from a pipe before the scanner got to them
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) return false;
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof IR_FILE_MAGIC] = {};
+    in.read(magic, sizeof magic);
+    return in.gcount() == sizeof magic && std::memcmp(magic, IR_FILE_MAGIC, sizeof magic) == 0;
+}
+
+// the operands of a record must be the ones its opcode uses: -1 where the
+// parser leaves a field unused, a register number where it reads or writes
+// one. Every VR the renamer hands out is below 3 * count, one per operand.
+static bool operandsValid(const IRRecord& record, size_t count, bool renamed) {
+    enum Use { UNUSED, CONSTANT, REGISTER };
+    Use uses[3] = {UNUSED, UNUSED, UNUSED};
+    switch (record.opcode) {
+        case TOKEN_LOADI:
+            uses[0] = CONSTANT;
+            uses[2] = REGISTER;
+            break;
+        case TOKEN_LOAD:
+        case TOKEN_STORE:
+            uses[0] = uses[2] = REGISTER;
+            break;
+        case TOKEN_ADD:
+        case TOKEN_SUB:
+        case TOKEN_MULT:
+        case TOKEN_LSHIFT:
+        case TOKEN_RSHIFT:
+            uses[0] = uses[1] = uses[2] = REGISTER;
+            break;
+        case TOKEN_OUTPUT:
+            uses[0] = CONSTANT;
+            break;
+        default:
+            break;
+    }
+
+    const int32_t sr[3] = {record.sr1, record.sr2, record.sr3};
+    const int32_t vr[3] = {record.vr1, record.vr2, record.vr3};
+    for (int i = 0; i < 3; i++) {
+        bool vrInRange = vr[i] >= 0 && (uint64_t)vr[i] < 3 * (uint64_t)count;
+        switch (uses[i]) {
+            case UNUSED:
+                if (sr[i] != -1 || vr[i] != -1) return false;
+                break;
+            case CONSTANT:
+                if (vr[i] != -1) return false;
+                break;
+            case REGISTER:
+                if (sr[i] < 0 || sr[i] > IR_MAX_REGISTER) return false;
+                if (renamed ? !vrInRange : (vr[i] != -1 && !vrInRange)) return false;
+                break;
+        }
+    }
+    return true;
+}
+
+IRFile::IRFile(const std::string& path)
+    : mapping(nullptr), length(0), valid(false), flags(0), count(0),
+      records(nullptr), lineOffsets(nullptr), lineText(nullptr) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        message = "Could not open file " + path;
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(IRFileHeader)) {
+        close(fd);
+        message = path + " is too short to be an IR file";
+        return;
+    }
+    length = info.st_size;
+    mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        message = "Could not map " + path;
+        return;
+    }
+
+    const char* base = static_cast<const char*>(mapping);
+    const IRFileHeader* header = reinterpret_cast<const IRFileHeader*>(base);
+    if (std::memcmp(header->magic, IR_FILE_MAGIC, sizeof header->magic) != 0) {
+        message = path + " is not an IR file";
+        return;
+    }
+    if (header->version != IR_FILE_VERSION || header->recordSize != sizeof(IRRecord)) {
+        message = path + ": unsupported IR file version " + std::to_string(header->version);
+        return;
+    }
+    size_t room = (length - sizeof(IRFileHeader)) / sizeof(IRRecord);
+    if (header->count > room) {
+        message = path + " is truncated";
+        return;
+    }
+
+    flags = header->flags;
+    count = header->count;
+    records = reinterpret_cast<const IRRecord*>(base + sizeof(IRFileHeader));
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].opcode > TOKEN_NOP) {
+            message = path + ": bad opcode in record " + std::to_string(i);
+            return;
+        }
+        if (!operandsValid(records[i], count, flags & IR_FILE_RENAMED)) {
+            message = path + ": bad operands in record " + std::to_string(i);
+            return;
+        }
+    }
+
+    if (flags & IR_FILE_LINES) {
+        size_t start = header->linesOffset;
+        size_t end = sizeof(IRFileHeader) + count * sizeof(IRRecord);
+        if (start != end || (length - start) / sizeof(uint32_t) < count + 1) {
+            message = path + ": bad line table";
+            return;
+        }
+        lineOffsets = reinterpret_cast<const uint32_t*>(base + start);
+        lineText = base + start + (count + 1) * sizeof(uint32_t);
+        size_t textLength = length - (lineText - base);
+        for (size_t i = 0; i < count; i++) {
+            if (lineOffsets[i] > lineOffsets[i + 1]) {
+                message = path + ": bad line table";
+                return;
+            }
+        }
+        if (lineOffsets[count] > textLength) {
+            message = path + " is truncated";
+            return;
+        }
+    }
+
+    valid = true;
+}
+
+IRFile::~IRFile() {
+    if (mapping) munmap(mapping, length);
+}
+
+std::string_view IRFile::sourceLine(size_t i) const {
+    if (!lineOffsets || i >= count) return {};
+    return std::string_view(lineText + lineOffsets[i], lineOffsets[i + 1] - lineOffsets[i]);
+}
+
+IRNode* IRFile::toList() const {
+    IRNode* head = nullptr;
+    IRNode* tail = nullptr;
+    for (size_t i = 0; i < count; i++) {
+        const IRRecord& record = records[i];
+        IRNode* node = new IRNode();
+        node->line = record.line;
+        node->opcode = (TokenType)record.opcode;
+        node->sr1 = record.sr1;
+        node->sr2 = record.sr2;
+        node->sr3 = record.sr3;
+        node->vr1 = record.vr1;
+        node->vr2 = record.vr2;
+        node->vr3 = record.vr3;
+        node->prev = tail;
+        if (tail) tail->next = node;
+        else head = node;
+        tail = node;
+    }
+    return head;
+}
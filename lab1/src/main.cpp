@@ -1,8 +1,23 @@
 #include <iostream>
+#include <string>
 #include "scanner.h"
 #include "parser.h"
+#include "stats.h"
+#include "irfile.h"
 #include "cli.h"
 
+// --emit-ir: write the parsed block for the later stages
+static bool emitIR(const CLIOptions& args, const IRNode* head, PhaseStats& stats) {
+	if (args.irFile.empty()) return true;
+	PhaseStats::Scope phase(stats, "emit-ir");
+	std::string error;
+	if (!writeIRFile(args.irFile, head, false, args.filename, error)) {
+		std::cerr << "Error: " << error << std::endl;
+		return false;
+	}
+	return true;
+}
+
 int main(int argc, char* argv[]) {
 	CLIOptions args = parse_arguments(argc, argv);
 
@@ -12,12 +27,16 @@ int main(int argc, char* argv[]) {
 		return 1;
 	}
 
+	PhaseStats stats("434fe", args.stats);
+
 	switch (args.mode) {
 		case MODE_HELP:
 			print_help();
 			break;
 
 		case MODE_SCAN: {
+			// scanAll prints each token as it goes
+			PhaseStats::Scope phase(stats, "scan");
 			Scanner scanner(args.filename);
 			scanner.scanAll();
 			break;
@@ -26,7 +45,12 @@ int main(int argc, char* argv[]) {
 		case MODE_PARSE: {
 			Scanner scanner(args.filename);
 			Parser parser(scanner);
-			parser.parseAll();
+			IRNode* irHead = nullptr;
+			{
+				PhaseStats::Scope phase(stats, "scan+parse");
+				irHead = parser.parseAll();
+			}
+			if (!emitIR(args, irHead, stats)) return 1;
 			break;
 		}
 			
@@ -34,12 +58,19 @@ int main(int argc, char* argv[]) {
 		case MODE_PRINT_IR:
 			Scanner scanner(args.filename);
 			Parser parser(scanner);
-			IRNode* irHead = parser.parseAll();
+			IRNode* irHead = nullptr;
+			{
+				PhaseStats::Scope phase(stats, "scan+parse");
+				irHead = parser.parseAll();
+			}
+			if (!emitIR(args, irHead, stats)) return 1;
 			if (irHead != nullptr) {
+				PhaseStats::Scope phase(stats, "emit");
 				parser.printIR();
 			}
 			break;
 	}
 
+	stats.print(std::cerr, args.statsJson);
 	return 0;
 }
\ No newline at end of file
@@ -2,8 +2,9 @@
 #include <cctype>
 #include <unordered_map>
 
-//map to identify opcode
-std::unordered_map<std::string, TokenType> opcodeMap = {
+//map to identify opcode; const and local to this file, so scanners on
+//different threads only ever read it
+static const std::unordered_map<std::string, TokenType> opcodeMap = {
     {"load", TOKEN_LOAD},
     {"loadI", TOKEN_LOADI},
     {"store", TOKEN_STORE},
@@ -152,8 +153,9 @@ Token Scanner::nextToken() {
         }
 
         // check opcode map
-        if (opcodeMap.count(lex)) {
-            return {opcodeMap[lex], line, lex};
+        auto opcode = opcodeMap.find(lex);
+        if (opcode != opcodeMap.end()) {
+            return {opcode->second, line, lex};
         }
 
         return {TOKEN_ERROR, line, lex};
@@ -1,14 +1,25 @@
 #include "allocator.h"
 #include <iostream>
 #include <climits>
+#include <algorithm>
+#include <optional>
+#include <string>
 
 // start address for memory spills
 static const int SPILL_BASE_ADDRESS = 32768;
 
 // constructor 
-RegisterAllocator::RegisterAllocator(int registerCount) 
-    : registerCount(registerCount), nextSpillAddress(SPILL_BASE_ADDRESS) {
-    
+RegisterAllocator::RegisterAllocator(int registerCount) {
+    reset(registerCount);
+}
+
+void RegisterAllocator::reset(int count) {
+    registerCount = count;
+    nextSpillAddress = SPILL_BASE_ADDRESS;
+    virtualToPhysicalMap.clear();
+    spillLocationMap.clear();
+    allocatedInstructions.clear();
+
     // setup physical register tracking
     physicalRegisters.resize(registerCount);
     for (auto& registerState : physicalRegisters) { 
@@ -160,7 +171,7 @@ int RegisterAllocator::findRegisterWithFurthestNextUse(int excludedRegister1, in
 }
 
 // generates code to save a virtual register from a physical register to memory
-void RegisterAllocator::generateSpillCode(int physicalRegister, std::vector<std::string>& outputBuffer) {
+void RegisterAllocator::generateSpillCode(int physicalRegister, std::vector<IRNode>& outputBuffer) {
     int virtualRegister = physicalRegisters[physicalRegister].allocatedVirtualRegister;
     if (virtualRegister < 0) {
         return; // nothing to spill
@@ -170,8 +181,8 @@ void RegisterAllocator::generateSpillCode(int physicalRegister, std::vector<std:
     int scratchReg = getScratchRegisterIndex();
     
     // emit loadI to get address into scratch, then store register value
-    outputBuffer.push_back("loadI " + std::to_string(spillAddress) + " => " + formatRegister(scratchReg));
-    outputBuffer.push_back("store " + formatRegister(physicalRegister) + " => " + formatRegister(scratchReg));
+    outputBuffer.push_back(makeInstruction(TOKEN_LOADI, spillAddress, -1, -1, scratchReg));
+    outputBuffer.push_back(makeInstruction(TOKEN_STORE, -1, physicalRegister, -1, scratchReg));
 
     // cleanup mapping
     virtualToPhysicalMap.erase(virtualRegister);
@@ -180,7 +191,7 @@ void RegisterAllocator::generateSpillCode(int physicalRegister, std::vector<std:
 }
 
 // generates code to load a spilled virtual register from memory back to a physical register
-void RegisterAllocator::generateRestoreCode(int virtualRegister, int physicalRegister, std::vector<std::string>& outputBuffer) {
+void RegisterAllocator::generateRestoreCode(int virtualRegister, int physicalRegister, std::vector<IRNode>& outputBuffer) {
     auto iterator = spillLocationMap.find(virtualRegister);
     if (iterator == spillLocationMap.end()) {
         return; // was never spilled, so nothing to restore
@@ -188,13 +199,13 @@ void RegisterAllocator::generateRestoreCode(int virtualRegister, int physicalReg
     
     int scratchReg = getScratchRegisterIndex();
     // emit loadI to get address into scratch, then load value into target register
-    outputBuffer.push_back("loadI " + std::to_string(iterator->second) + " => " + formatRegister(scratchReg));
-    outputBuffer.push_back("load " + formatRegister(scratchReg) + " => " + formatRegister(physicalRegister));
+    outputBuffer.push_back(makeInstruction(TOKEN_LOADI, iterator->second, -1, -1, scratchReg));
+    outputBuffer.push_back(makeInstruction(TOKEN_LOAD, -1, scratchReg, -1, physicalRegister));
 }
 
 // ensures a source operand (virtual register) is in a physical register
 // spills another register if necessary to make room
-int RegisterAllocator::prepareSourceOperand(int virtualRegister, int nextUseDistance, int lockedRegister1, int lockedRegister2, std::vector<std::string>& outputBuffer) {
+int RegisterAllocator::prepareSourceOperand(int virtualRegister, int nextUseDistance, int lockedRegister1, int lockedRegister2, std::vector<IRNode>& outputBuffer) {
     if (virtualRegister < 0) return -1;
     
     // check if virtual register is already in a physical register
@@ -228,7 +239,7 @@ int RegisterAllocator::prepareSourceOperand(int virtualRegister, int nextUseDist
 }
 
 // similar to prepareSourceOperand but can use the scratch register as a last resort
-int RegisterAllocator::prepareSourceOperandWithScratch(int virtualRegister, int nextUseDistance, int lockedRegister, std::vector<std::string>& outputBuffer) {
+int RegisterAllocator::prepareSourceOperandWithScratch(int virtualRegister, int nextUseDistance, int lockedRegister, std::vector<IRNode>& outputBuffer) {
     if (virtualRegister < 0) return -1;
     
     // check if already in a permanent register
@@ -272,7 +283,7 @@ int RegisterAllocator::prepareSourceOperandWithScratch(int virtualRegister, int
 
 // finds a physical register for a destination operand
 int RegisterAllocator::prepareDestinationOperand(int lockedRegister1, int lockedRegister2,
-                                                 std::vector<std::string>& outputBuffer) {
+                                                 std::vector<IRNode>& outputBuffer) {
     int physicalRegister = findFreePhysicalRegister();
     if (physicalRegister != -1) return physicalRegister;
     
@@ -297,17 +308,214 @@ int RegisterAllocator::prepareDestinationOperand(int lockedRegister1, int locked
     return victimRegister;
 }
 
+// records that a physical register now holds a newly defined virtual register.
+// The renamer reuses one VR per source register, so the VR may still sit in
+// another physical register from its previous definition; that copy is dead.
+void RegisterAllocator::bindDestination(int physicalRegister, int virtualRegister, int nextUseDistance) {
+    int previousVirtualReg = physicalRegisters[physicalRegister].allocatedVirtualRegister;
+    if (previousVirtualReg >= 0 && previousVirtualReg != virtualRegister) {
+        virtualToPhysicalMap.erase(previousVirtualReg);
+    }
+
+    auto staleCopy = virtualToPhysicalMap.find(virtualRegister);
+    if (staleCopy != virtualToPhysicalMap.end() && staleCopy->second != physicalRegister) {
+        physicalRegisters[staleCopy->second].allocatedVirtualRegister = -1;
+        physicalRegisters[staleCopy->second].nextUseDistance = INT_MAX;
+    }
+
+    physicalRegisters[physicalRegister] = {virtualRegister, nextUseDistance};
+    virtualToPhysicalMap[virtualRegister] = physicalRegister;
+}
+
+// builds one allocated instruction; constant is the loadI/output immediate
+IRNode RegisterAllocator::makeInstruction(TokenType opcode, int constant, int source1, int source2, int destination) {
+    IRNode node;
+    node.line = 0;
+    node.opcode = opcode;
+    bool immediate = (opcode == TOKEN_LOADI || opcode == TOKEN_OUTPUT);
+    node.sr1 = immediate ? constant : source1;
+    node.vr1 = node.pr1 = source1;
+    node.sr2 = node.vr2 = node.pr2 = source2;
+    node.sr3 = node.vr3 = node.pr3 = destination;
+    return node;
+}
+
+// peephole pass over the allocated block. A forward walk tracks the constant
+// each register got from a loadI and the memory word it is known to match
+// after a store or load through a constant address; a backward walk then
+// drops loadIs whose register is rewritten before it is read
+void RegisterAllocator::peephole() {
+    std::vector<IRNode>& code = allocatedInstructions;
+    int registers = registerCount;
+    for (const IRNode& op : code) {
+        registers = std::max({registers, op.vr2 + 1, op.vr3 + 1});
+        if (op.opcode != TOKEN_LOADI && op.opcode != TOKEN_OUTPUT)
+            registers = std::max(registers, op.vr1 + 1);
+    }
+
+    std::vector<std::optional<int>> constant(registers);  // register -> value loaded by loadI
+    std::vector<std::optional<int>> slot(registers);      // register -> address it mirrors
+    std::vector<bool> removed(code.size(), false);
+
+    auto overwrite = [&](int reg) {
+        constant[reg].reset();
+        slot[reg].reset();
+    };
+
+    for (size_t i = 0; i < code.size(); i++) {
+        const IRNode& op = code[i];
+        switch (op.opcode) {
+            case TOKEN_LOADI:
+                // back-to-back scratch loadIs of the same spill address
+                if (constant[op.vr3] == op.sr1) {
+                    removed[i] = true;
+                } else {
+                    overwrite(op.vr3);
+                    constant[op.vr3] = op.sr1;
+                }
+                break;
+
+            case TOKEN_LOAD: {
+                // a restore right after the spill of the same register
+                std::optional<int> address = constant[op.vr1];
+                if (address && slot[op.vr3] == address) {
+                    removed[i] = true;
+                } else {
+                    overwrite(op.vr3);
+                    slot[op.vr3] = address;
+                }
+                break;
+            }
+
+            case TOKEN_STORE: {
+                // the word changes, so registers mirroring it no longer do
+                std::optional<int> address = constant[op.vr3];
+                for (auto& mirrored : slot) {
+                    if (mirrored && (!address || mirrored == address)) mirrored.reset();
+                }
+                slot[op.vr1] = address;
+                break;
+            }
+
+            case TOKEN_ADD:
+            case TOKEN_SUB:
+            case TOKEN_MULT:
+            case TOKEN_LSHIFT:
+            case TOKEN_RSHIFT: {
+                // x + 0, x - 0, x * 1 and shifts by 0 written back to x
+                int identity = (op.opcode == TOKEN_MULT) ? 1 : 0;
+                bool commutative = (op.opcode == TOKEN_ADD || op.opcode == TOKEN_MULT);
+                bool selfMove = (op.vr1 == op.vr3 && constant[op.vr2] == identity) ||
+                                (commutative && op.vr2 == op.vr3 && constant[op.vr1] == identity);
+                if (selfMove) removed[i] = true;
+                else overwrite(op.vr3);
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    // nothing is live past the end of the block
+    std::vector<bool> live(registers, false);
+    for (size_t i = code.size(); i-- > 0;) {
+        if (removed[i]) continue;
+        const IRNode& op = code[i];
+        switch (op.opcode) {
+            case TOKEN_LOADI:
+                if (!live[op.vr3]) removed[i] = true;
+                live[op.vr3] = false;
+                break;
+            case TOKEN_LOAD:
+                live[op.vr3] = false;
+                live[op.vr1] = true;
+                break;
+            case TOKEN_STORE:
+                live[op.vr1] = true;
+                live[op.vr3] = true;
+                break;
+            case TOKEN_ADD:
+            case TOKEN_SUB:
+            case TOKEN_MULT:
+            case TOKEN_LSHIFT:
+            case TOKEN_RSHIFT:
+                live[op.vr3] = false;
+                live[op.vr1] = true;
+                live[op.vr2] = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (!removed[i]) code[kept++] = code[i];
+    }
+    code.resize(kept);
+}
+
+// the whole block is formatted first and written at once
+void RegisterAllocator::printAllocatedCode(std::ostream& out) const {
+    std::string text;
+    text.reserve(allocatedInstructions.size() * 24);
+    auto reg = [&](int r) { text += 'r'; text += std::to_string(r); };
+
+    for (const IRNode& op : allocatedInstructions) {
+        switch (op.opcode) {
+            case TOKEN_LOADI:
+                text += "loadI " + std::to_string(op.sr1) + " => ";
+                reg(op.vr3);
+                break;
+            case TOKEN_OUTPUT:
+                text += "output " + std::to_string(op.sr1);
+                break;
+            case TOKEN_LOAD:
+            case TOKEN_STORE:
+                text += (op.opcode == TOKEN_LOAD) ? "load " : "store ";
+                reg(op.vr1);
+                text += " => ";
+                reg(op.vr3);
+                break;
+            case TOKEN_ADD:
+            case TOKEN_SUB:
+            case TOKEN_MULT:
+            case TOKEN_LSHIFT:
+            case TOKEN_RSHIFT:
+                switch (op.opcode) {
+                    case TOKEN_ADD: text += "add "; break;
+                    case TOKEN_SUB: text += "sub "; break;
+                    case TOKEN_MULT: text += "mult "; break;
+                    case TOKEN_LSHIFT: text += "lshift "; break;
+                    default: text += "rshift "; break;
+                }
+                reg(op.vr1);
+                text += ", ";
+                reg(op.vr2);
+                text += " => ";
+                reg(op.vr3);
+                break;
+            default:
+                continue;
+        }
+        text += '\n';
+    }
+    out << text;
+}
+
 // main entry point for register allocation
 // performs a single pass over the instructions and assigns physical registers
-void RegisterAllocator::allocateRegisters(IRNode* instructionList) {
-    if (!instructionList) return;
+IRNode* RegisterAllocator::allocateRegisters(IRNode* instructionList) {
+    allocatedInstructions.clear();
+    if (!instructionList) return nullptr;
 
     // compute next use distances first to inform spill decisions
     computeFurthestNextUse(instructionList);
 
     // iterate through each instruction in the IR
     for (auto* instruction = instructionList; instruction; instruction = instruction->next) {
-        std::vector<std::string> preInstructionBuffer; // holds spill/restore code
+        std::vector<IRNode> preInstructionBuffer; // holds spill/restore code
         int sourceReg1 = -1, sourceReg2 = -1, destReg = -1;
 
         switch (instruction->opcode) {
@@ -325,17 +533,11 @@ void RegisterAllocator::allocateRegisters(IRNode* instructionList) {
                 }
 
                 // update mappings for destination virtual register
-                int previousVirtualReg = physicalRegisters[destReg].allocatedVirtualRegister;
-                if (previousVirtualReg >= 0 && previousVirtualReg != instruction->vr3) {
-                    virtualToPhysicalMap.erase(previousVirtualReg);
-                }
-
-                physicalRegisters[destReg] = {instruction->vr3, instruction->nu3}; 
-                virtualToPhysicalMap[instruction->vr3] = destReg;
+                bindDestination(destReg, instruction->vr3, instruction->nu3);
 
                 // output all generated spill/restore instructions before the main op
                 for (auto& preInstruction : preInstructionBuffer) emitInstruction(preInstruction);
-                emitInstruction("load " + formatRegister(sourceReg1) + " => " + formatRegister(destReg));
+                emitInstruction(makeInstruction(TOKEN_LOAD, -1, sourceReg1, -1, destReg));
 
                 // cleanup if source not reused
                 if (destReg != sourceReg1 && instruction->nu1 == INT_MAX) releasePhysicalRegister(sourceReg1);
@@ -346,14 +548,10 @@ void RegisterAllocator::allocateRegisters(IRNode* instructionList) {
                 // loadi only has a destination
                 destReg = prepareDestinationOperand(-1, -1, preInstructionBuffer);
 
-                int previousVirtualReg = physicalRegisters[destReg].allocatedVirtualRegister;
-                if (previousVirtualReg >= 0) virtualToPhysicalMap.erase(previousVirtualReg);
-
-                physicalRegisters[destReg] = {instruction->vr3, instruction->nu3}; 
-                virtualToPhysicalMap[instruction->vr3] = destReg;
+                bindDestination(destReg, instruction->vr3, instruction->nu3);
 
                 for (auto& preInstruction : preInstructionBuffer) emitInstruction(preInstruction);
-                emitInstruction("loadI " + std::to_string(instruction->sr1) + " => " + formatRegister(destReg));
+                emitInstruction(makeInstruction(TOKEN_LOADI, instruction->sr1, -1, -1, destReg));
                 break;
             }
 
@@ -363,7 +561,7 @@ void RegisterAllocator::allocateRegisters(IRNode* instructionList) {
                 sourceReg2 = prepareSourceOperand(instruction->vr3, instruction->nu3, sourceReg1, -1, preInstructionBuffer);
 
                 for (auto& preInstruction : preInstructionBuffer) emitInstruction(preInstruction);
-                emitInstruction("store " + formatRegister(sourceReg1) + " => " + formatRegister(sourceReg2));
+                emitInstruction(makeInstruction(TOKEN_STORE, -1, sourceReg1, -1, sourceReg2));
 
                 // free registers if no future uses
                 if (instruction->nu1 == INT_MAX) releasePhysicalRegister(sourceReg1);
@@ -400,28 +598,11 @@ void RegisterAllocator::allocateRegisters(IRNode* instructionList) {
                 }
 
                 // update destination mapping
-                int previousVirtualReg = physicalRegisters[destReg].allocatedVirtualRegister;
-                if (previousVirtualReg >= 0 && previousVirtualReg != instruction->vr3) {
-                    virtualToPhysicalMap.erase(previousVirtualReg);
-                }
-
-                physicalRegisters[destReg] = {instruction->vr3, instruction->nu3}; 
-                virtualToPhysicalMap[instruction->vr3] = destReg;
+                bindDestination(destReg, instruction->vr3, instruction->nu3);
 
                 for (auto& preInstruction : preInstructionBuffer) emitInstruction(preInstruction);
 
-                // determine string opcode
-                std::string operation;
-                switch (instruction->opcode) {
-                    case TOKEN_ADD: operation="add"; break; 
-                    case TOKEN_SUB: operation="sub"; break;
-                    case TOKEN_MULT: operation="mult"; break; 
-                    case TOKEN_LSHIFT: operation="lshift"; break;
-                    case TOKEN_RSHIFT: operation="rshift"; break; 
-                    default: break;
-                }
-
-                emitInstruction(operation + " " + formatRegister(sourceReg1) + ", " + formatRegister(sourceReg2) + " => " + formatRegister(destReg));
+                emitInstruction(makeInstruction(instruction->opcode, -1, sourceReg1, sourceReg2, destReg));
 
                 // special handling if we used the scratch register for an operand
                 int scratchReg = getScratchRegisterIndex();
@@ -443,7 +624,7 @@ void RegisterAllocator::allocateRegisters(IRNode* instructionList) {
 
             case TOKEN_OUTPUT: 
                 // output just prints a constant, no registers involved
-                emitInstruction("output " + std::to_string(instruction->sr1)); 
+                emitInstruction(makeInstruction(TOKEN_OUTPUT, instruction->sr1, -1, -1, -1));
                 break;
 
             case TOKEN_NOP: 
@@ -455,4 +636,16 @@ void RegisterAllocator::allocateRegisters(IRNode* instructionList) {
                 break;
         }
     }
+
+    peephole();
+
+    // link the output only once it is complete, so the vector never moves
+    IRNode* previous = nullptr;
+    for (auto& instruction : allocatedInstructions) {
+        instruction.prev = previous;
+        instruction.next = nullptr;
+        if (previous) previous->next = &instruction;
+        previous = &instruction;
+    }
+    return allocatedInstructions.empty() ? nullptr : &allocatedInstructions.front();
 }
\ No newline at end of file
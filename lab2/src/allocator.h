@@ -3,9 +3,8 @@
 #include "parser.h"
 #include <vector>
 #include <unordered_map>
-#include <string>
 #include <climits>
-#include <iostream>
+#include <ostream>
 
 // Tracks the state of a physical register
 struct PhysicalRegister {
@@ -16,9 +15,17 @@ struct PhysicalRegister {
 class RegisterAllocator {
 public:
     explicit RegisterAllocator(int registerCount); //constructor
+
+    // back to the state of a new allocator for registerCount registers,
+    // keeping the memory already allocated
+    void reset(int registerCount);
     
-    // main allocate function
-    void allocateRegisters(IRNode* instructionList);
+    // main allocate function; returns the allocated block as a new IR list
+    // (owned by the allocator) whose sr/vr/pr fields all hold physical registers
+    IRNode* allocateRegisters(IRNode* instructionList);
+
+    // write the allocated block as ILOC text in a single write
+    void printAllocatedCode(std::ostream& out) const;
 
 private:
     int registerCount;  // physical registers available
@@ -26,6 +33,7 @@ private:
     std::unordered_map<int, int> virtualToPhysicalMap;  // map virtual register -> physical register
     std::unordered_map<int, int> spillLocationMap;  // map virtual register -> memory spill address
     int nextSpillAddress;   // next address for spills
+    std::vector<IRNode> allocatedInstructions;  // allocator output, in order
 
     // allocation helpers
     int getScratchRegisterIndex() const;    // registerCount - 1
@@ -38,15 +46,21 @@ private:
     int findRegisterWithFurthestNextUse(int excludedRegister1, int excludedRegister2);
     
     // spill and restore operations
-    void generateSpillCode(int physicalRegister, std::vector<std::string>& outputBuffer);
-    void generateRestoreCode(int virtualRegister, int physicalRegister, std::vector<std::string>& outputBuffer);
+    void generateSpillCode(int physicalRegister, std::vector<IRNode>& outputBuffer);
+    void generateRestoreCode(int virtualRegister, int physicalRegister, std::vector<IRNode>& outputBuffer);
     
     // operand preparation
-    int prepareSourceOperand(int virtualRegister, int nextUseDistance, int lockedRegister1, int lockedRegister2, std::vector<std::string>& outputBuffer);
-    int prepareSourceOperandWithScratch(int virtualRegister, int nextUseDistance, int lockedRegister, std::vector<std::string>& outputBuffer);
-    int prepareDestinationOperand(int lockedRegister1, int lockedRegister2, std::vector<std::string>& outputBuffer);
+    int prepareSourceOperand(int virtualRegister, int nextUseDistance, int lockedRegister1, int lockedRegister2, std::vector<IRNode>& outputBuffer);
+    int prepareSourceOperandWithScratch(int virtualRegister, int nextUseDistance, int lockedRegister, std::vector<IRNode>& outputBuffer);
+    void bindDestination(int physicalRegister, int virtualRegister, int nextUseDistance);
+    int prepareDestinationOperand(int lockedRegister1, int lockedRegister2, std::vector<IRNode>& outputBuffer);
+
+    // cleanup of the finished output: drops loadIs of a value the register
+    // already holds, reloads of a slot the register was just spilled from,
+    // ops that copy a register onto itself and loadIs nothing reads
+    void peephole();
 
-    // print helpers
-    std::string formatRegister(int registerIndex) { return "r" + std::to_string(registerIndex); }
-    void emitInstruction(const std::string& instruction) { std::cout << instruction << "\n"; }
+    // output helpers
+    static IRNode makeInstruction(TokenType opcode, int constant, int source1, int source2, int destination);
+    void emitInstruction(const IRNode& instruction) { allocatedInstructions.push_back(instruction); }
 };
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// --batch: the input files named on the command line. A directory stands
+// for the .i and .ilir files directly inside it. Largest first, so the
+// long jobs start early and the short ones fill in at the end.
+std::vector<std::string> collectBatchInputs(const std::vector<std::string>& paths, std::string& error);
+
+// run task(i) for every i in [0, count) on `threads` workers. The tasks
+// are dealt out round-robin; a worker takes its own from the front and,
+// once they run out, steals from the back of another worker's queue.
+// task must be safe to call from several threads at once.
+void runWorkStealing(size_t count, int threads, const std::function<void(size_t)>& task);
+
+// write what one task reported to out in a single piece, each line
+// prefixed with the task's input, so lines from tasks running at once
+// neither interleave nor lose track of the file they are about
+void printTaskDiagnostics(std::ostream& out, const std::string& input, const std::string& text);
@@ -1,38 +1,137 @@
 #include "cli2.h"
 #include <iostream>
 #include <stdexcept>
+#include <thread>
 
 void print_help() {
 	std::cout << "Usage: 434alloc [option] <name>" << std::endl;
+	std::cout << "       434alloc --batch [-j <n>] -x|<k> <name>..." << std::endl;
 	std::cout << "Options:" << std::endl;
 	std::cout << "  -h        	Print this help message" << std::endl;
 	std::cout << "  -x <name> 	Scan, parse, and print renamed ILOC block" << std::endl;
 	std::cout << "  <k> <name> 	Allocate registers using k registers (3 <= k <= 64)" << std::endl;
+	std::cout << "            	<name> may be a binary IR file (.ilir); it is read" << std::endl;
+	std::cout << "            	without scanning, parsing or, if renamed, renaming" << std::endl;
+	std::cout << "  --batch   	Process every <name> given, in parallel; a directory stands" << std::endl;
+	std::cout << "            	for the .i and .ilir files in it. Each result is written" << std::endl;
+	std::cout << "            	next to its input as <name>.renamed (-x) or <name>.alloc" << std::endl;
+	std::cout << "  -j <n>    	Worker threads for --batch (default: one per core)" << std::endl;
+	std::cout << "  --emit-ir <file>" << std::endl;
+	std::cout << "            	Also write the renamed block to <file> as binary IR" << std::endl;
+	std::cout << "  --cache <dir>	Keep the output in <dir>, keyed by a hash of the input" << std::endl;
+	std::cout << "            	bytes and the options; an identical run prints it from" << std::endl;
+	std::cout << "            	there (not with --emit-ir)" << std::endl;
+	std::cout << "  --cache-size <MB>" << std::endl;
+	std::cout << "            	Drop the least recently used entries once the cache" << std::endl;
+	std::cout << "            	holds more than <MB> megabytes (default 256)" << std::endl;
+	std::cout << "  --stats[=json]	Also print wall and CPU time, allocations and peak RSS" << std::endl;
+	std::cout << "            	for each phase to stderr, as a table or as JSON" << std::endl;
+}
+
+// a whole argument as an int; std::stoi alone takes "10abc" as 10
+static bool parseInt(const std::string& text, int& value) {
+	try {
+		size_t used = 0;
+		value = std::stoi(text, &used);
+		return used == text.size();
+	} catch (std::exception&) {
+		return false;
+	}
 }
 
 CLIOptions parse_arguments(int argc, char* argv[]) {
     CLIOptions result;
     result.valid = true;
 	result.k = 0;
-    
+	result.cacheMb = 256;
+	result.batch = false;
+	unsigned cores = std::thread::hardware_concurrency();
+	result.jobs = cores ? (int)cores : 1;
+	result.stats = false;
+	result.statsJson = false;
+
+	// --stats, --emit-ir, --cache, --batch and -j may go anywhere; take them
+	// out before matching the forms below
+	std::vector<char*> args;
+	for (int i = 0; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i > 0 && (arg == "--stats" || arg == "--stats=json")) {
+			result.stats = true;
+			result.statsJson = (arg == "--stats=json");
+		} else if (i > 0 && arg == "--batch") {
+			result.batch = true;
+		} else if (i > 0 && arg == "-j") {
+			if (i + 1 >= argc) {
+				result.valid = false;
+				result.errorMessage = "-j requires a number of threads";
+				return result;
+			}
+			if (!parseInt(argv[++i], result.jobs)) result.jobs = -1;
+			if (result.jobs <= 0) {
+				result.valid = false;
+				result.errorMessage = "Invalid thread count: '" + std::string(argv[i]) + "' is not a positive number.";
+				return result;
+			}
+		} else if (i > 0 && arg == "--cache") {
+			if (i + 1 >= argc) {
+				result.valid = false;
+				result.errorMessage = "--cache requires a directory";
+				return result;
+			}
+			result.cacheDir = argv[++i];
+		} else if (i > 0 && arg == "--cache-size") {
+			if (i + 1 >= argc) {
+				result.valid = false;
+				result.errorMessage = "--cache-size requires a number of megabytes";
+				return result;
+			}
+			if (!parseInt(argv[++i], result.cacheMb)) result.cacheMb = -1;
+			if (result.cacheMb <= 0) {
+				result.valid = false;
+				result.errorMessage = "Invalid cache size: '" + std::string(argv[i]) + "' is not a positive number of megabytes.";
+				return result;
+			}
+		} else if (i > 0 && arg == "--emit-ir") {
+			if (i + 1 >= argc) {
+				result.valid = false;
+				result.errorMessage = "--emit-ir requires an output file name";
+				return result;
+			}
+			result.irFile = argv[++i];
+		} else {
+			args.push_back(argv[i]);
+		}
+	}
+	argc = (int)args.size();
+	argv = args.data();
+
 	// -h flag
     if (argc == 2 && std::string(argv[1]) == "-h") {
 		result.mode = MODE_HELP;
 		return result;
 	}
 
+	// --batch takes any number of inputs after -x or k
+	bool hasInputs = result.batch ? argc >= 3 : argc == 3;
+	if (hasInputs) {
+		result.inputs.assign(argv + 2, argv + argc);
+		if (result.batch && (!result.irFile.empty() || !result.cacheDir.empty())) {
+			result.valid = false;
+			result.errorMessage = "--emit-ir and --cache cannot be combined with --batch";
+			return result;
+		}
+	}
+
 	// -x flag
-	if (argc == 3 && std::string(argv[1]) == "-x") {
+	if (hasInputs && std::string(argv[1]) == "-x") {
 		result.mode = MODE_RENAME;
 		result.filename = std::string(argv[2]);
 		return result;
 	}
 
 	// k flag
-	if (argc == 3) {
-		try {
-			result.k = std::stoi(argv[1]);
-		} catch (std::exception&) {
+	if (hasInputs) {
+		if (!parseInt(argv[1], result.k)) {
 			result.valid = false;
 			result.errorMessage = "Invalid argument: '" + std::string(argv[1]) + "' is not a valid register count or flag.";
 			return result;
@@ -50,6 +149,6 @@ CLIOptions parse_arguments(int argc, char* argv[]) {
 	}
 
 	result.valid = false;
-	result.errorMessage = "Usage: 434alloc -h | 434alloc -x <file> | 434alloc k <file>";
+	result.errorMessage = "Usage: 434alloc -h | 434alloc -x <file> | 434alloc k <file> | 434alloc --batch -x|k <file>...";
 	return result;
 }
\ No newline at end of file
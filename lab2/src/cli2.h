@@ -12,7 +12,15 @@ enum Mode {
 struct CLIOptions {
     Mode mode;
     std::string filename;
+    bool batch;           // --batch: process every input, files or directories
+    std::vector<std::string> inputs; // the inputs of --batch
+    int jobs;             // -j N: worker threads for --batch
     int k;   //number of registers
+    std::string irFile;   // --emit-ir <file>: also write the renamed block as binary IR
+    std::string cacheDir; // --cache <dir>: reuse output for identical input and options
+    int cacheMb;          // --cache-size N: bound on the cache directory in MB
+    bool stats;       // --stats: per-phase time and memory on stderr
+    bool statsJson;   // --stats=json: the same as one JSON object
     bool valid;
     std::string errorMessage;
 };
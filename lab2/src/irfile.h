@@ -0,0 +1,100 @@
+#pragma once
+
+#include "parser.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Binary IR files (.ilir). One stage can hand its parsed or renamed block
+// to the next without printing ILOC text and scanning it again.
+//
+//   header     IRFileHeader, 32 bytes
+//   records    count IRRecords, 32 bytes each, in block order
+//   lines      optional: count + 1 uint32 offsets into the text after them;
+//              the source line of op i is text[offsets[i], offsets[i + 1])
+//
+// Integers are in host byte order. A file written on a machine with the
+// other byte order fails the magic check rather than being misread.
+
+constexpr char IR_FILE_MAGIC[4] = {'I', 'L', 'I', 'R'};
+constexpr uint16_t IR_FILE_VERSION = 1;
+
+// largest source register a record may name, so that a register file
+// indexed by source register (as in ilocrun) stays small
+constexpr int32_t IR_MAX_REGISTER = (1 << 24) - 1;
+
+enum IRFileFlags : uint16_t {
+    IR_FILE_RENAMED = 1,    // vr fields hold the renamer's virtual registers
+    IR_FILE_LINES = 2,      // the line table is present
+};
+
+struct IRFileHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t recordSize;    // sizeof(IRRecord) when the file was written
+    uint32_t reserved;
+    uint64_t count;         // number of records
+    uint64_t linesOffset;   // byte offset of the line table; 0 = none
+};
+
+// one op; opcode is the TokenType of the opcode (TOKEN_LOAD .. TOKEN_NOP),
+// operands as the parser and renamer fill them in, -1 when unused. IRFile
+// rejects a record whose fields do not fit that pattern: the file is
+// mapped from outside and goes straight to the passes
+struct IRRecord {
+    uint32_t opcode;
+    int32_t line;
+    int32_t sr1, sr2, sr3;
+    int32_t vr1, vr2, vr3;
+};
+
+static_assert(sizeof(IRFileHeader) == 32, "IRFileHeader layout changed");
+static_assert(sizeof(IRRecord) == 32, "IRRecord layout changed");
+
+// write the block at head; sourceFile, when given, is the ILOC text it
+// came from, and the line of every op is copied into the line table
+bool writeIRFile(const std::string& path, const IRNode* head, bool renamed,
+                 const std::string& sourceFile, std::string& error);
+
+// a mapped .ilir file; the records are read in place
+class IRFile {
+public:
+    explicit IRFile(const std::string& path);
+
+    // read an IR file already in memory; `data` must outlive the IRFile
+    IRFile(const char* data, size_t size);
+    ~IRFile();
+    IRFile(const IRFile&) = delete;
+    IRFile& operator=(const IRFile&) = delete;
+
+    // true if path is a regular file that starts with the .ilir magic
+    static bool isIRFile(const std::string& path);
+
+    bool ok() const { return valid; }
+    const std::string& error() const { return message; }
+
+    bool renamed() const { return flags & IR_FILE_RENAMED; }
+    size_t size() const { return count; }
+    const IRRecord& operator[](size_t i) const { return records[i]; }
+
+    // source text of op i; empty without a line table
+    std::string_view sourceLine(size_t i) const;
+
+    // the block as a linked list of IRNodes, allocated like the parser's
+    IRNode* toList() const;
+
+private:
+    void check(const char* base, const std::string& name);
+
+    void* mapping;
+    size_t length;
+    bool valid;
+    uint16_t flags;
+    size_t count;
+    const IRRecord* records;
+    const uint32_t* lineOffsets;
+    const char* lineText;
+    std::string message;
+};
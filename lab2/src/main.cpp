@@ -2,9 +2,17 @@
 #include "parser.h"
 #include "renamer.h"
 #include "allocator.h"
+#include "stats.h"
+#include "irfile.h"
+#include "cache.h"
+#include "batch.h"
 #include "cli2.h"
+#include <atomic>
+#include <fstream>
 #include <iostream>
+#include <cstdio>
 #include <cstdlib>
+#include <sstream>
 
 // function to deallocate IR 
 void freeIR(IRNode* head) {
@@ -16,6 +24,128 @@ void freeIR(IRNode* head) {
     }
 }
 
+// scan or read, rename, then print or allocate; returns the exit status.
+// Diagnostics go to errors; for --batch a block with syntax errors fails
+// rather than being allocated in part
+static int run(const CLIOptions& options, PhaseStats& stats, std::ostream& out, std::ostream& errors) {
+    try {
+        IRNode* ir = nullptr;
+        bool binary = IRFile::isIRFile(options.filename);
+        bool renamed = false;
+        if (binary) {
+            // binary IR: no scanning or parsing
+            PhaseStats::Scope phase(stats, "read-ir");
+            IRFile file(options.filename);
+            if (!file.ok()) {
+                errors << "Error: " << file.error() << std::endl;
+                return 1;
+            }
+            ir = file.toList();
+            renamed = file.renamed();
+        } else {
+            PhaseStats::Scope phase(stats, "scan+parse");
+
+            // create scanner
+            Scanner scanner(options.filename);
+
+            // create parser
+            Parser parser(scanner);
+            if (options.batch) parser.setDiagnostics(errors);
+
+            // parse the entire file
+            ir = parser.parseAll();
+            if (options.batch && parser.hasErrors()) {
+                freeIR(ir);
+                return 1;
+            }
+        }
+
+        // rename registers first
+        RegisterRenamer renamer;
+        if (!renamed) {
+            PhaseStats::Scope phase(stats, "rename");
+            renamer.rename(ir);
+        }
+
+        if (!options.irFile.empty()) {
+            PhaseStats::Scope phase(stats, "emit-ir");
+            std::string error;
+            if (!writeIRFile(options.irFile, ir, true, binary ? "" : options.filename, error)) {
+                errors << "Error: " << error << std::endl;
+                freeIR(ir);
+                return 1;
+            }
+        }
+
+        if (options.mode == MODE_RENAME) {
+            //-x - print renamed code
+            PhaseStats::Scope phase(stats, "emit");
+            renamer.printRenamedIR(ir, out);
+        }
+        else if (options.mode == MODE_ALLOC) {
+            // now allocate it
+            RegisterAllocator alloc(options.k);
+            {
+                PhaseStats::Scope phase(stats, "allocate");
+                alloc.allocateRegisters(ir);
+            }
+            PhaseStats::Scope phase(stats, "emit");
+            alloc.printAllocatedCode(out);
+        }
+
+        // clean up IR nodes
+        freeIR(ir);
+
+    } catch (const std::exception& e) {
+        errors << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// --batch: process every input on a work-stealing pool; each result goes
+// next to its input. A task's diagnostics go to stderr once it finishes,
+// prefixed with its input; a failed task leaves no result behind
+static int runBatch(const CLIOptions& options) {
+    std::string error;
+    std::vector<std::string> inputs = collectBatchInputs(options.inputs, error);
+    if (!error.empty()) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+    const char* suffix = options.mode == MODE_RENAME ? ".renamed" : ".alloc";
+
+    std::atomic<int> failed(0);
+    runWorkStealing(inputs.size(), options.jobs, [&](size_t i) {
+        CLIOptions single = options;
+        single.filename = inputs[i];
+        std::string result = single.filename + suffix;
+        PhaseStats quiet("434alloc", false);
+        std::ostringstream errors;
+        int status = 1;
+        // the Scanner exits on a file it cannot open, so check first
+        if (!std::ifstream(single.filename).is_open()) {
+            errors << "Error: Could not open file" << std::endl;
+        } else {
+            std::ofstream out(result, std::ios::binary);
+            if (!out.is_open()) {
+                errors << "Error: Could not open file " << result << std::endl;
+            } else {
+                status = run(single, quiet, out, errors);
+                if (!out.flush()) status = 1;
+                out.close();
+                if (status != 0) std::remove(result.c_str());
+            }
+        }
+        printTaskDiagnostics(std::cerr, single.filename, errors.str());
+        if (status != 0) failed++;
+    });
+
+    std::cerr << "434alloc: " << inputs.size() << " files, " << failed.load() << " failed" << std::endl;
+    return failed.load() ? 1 : 0;
+}
+
 int main(int argc, char* argv[]) {
     // parse cli arguments
     CLIOptions options = parse_arguments(argc, argv);
@@ -30,39 +160,62 @@ int main(int argc, char* argv[]) {
         return 0;
     }
     
-    try {
-        // create scanner
-        Scanner scanner(options.filename);
-        
-        // create parser
-        Parser parser(scanner);
-        
-        // parse the entire file
-        IRNode* ir = parser.parseAll();
-        
-        if (options.mode == MODE_RENAME) {
-            //-x - rename and print
-            RegisterRenamer renamer;
-            renamer.rename(ir);
-            renamer.printRenamedIR(ir);
-        }
-        else if (options.mode == MODE_ALLOC) {
-            // rename egisters first
-            RegisterRenamer renamer;
-            renamer.rename(ir);
-            
-            // now allocate it
-            RegisterAllocator alloc(options.k);
-            alloc.allocateRegisters(ir);
+    PhaseStats stats("434alloc", options.stats);
+
+    if (options.batch) {
+        int status = 0;
+        {
+            PhaseStats::Scope phase(stats, "batch");
+            status = runBatch(options);
         }
-        
-        // clean up IR nodes
-        freeIR(ir);
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
-        return 1;
+        stats.print(std::cerr, options.statsJson);
+        return status;
     }
-    
-    return 0;
-}
\ No newline at end of file
+
+    // --emit-ir writes a file the cache does not keep
+    if (options.cacheDir.empty() || !options.irFile.empty()) {
+        int status = run(options, stats, std::cout, std::cerr);
+        stats.print(std::cerr, options.statsJson);
+        return status;
+    }
+
+    ResultCache cache(options.cacheDir, (uint64_t)options.cacheMb << 20);
+    std::string key = "434alloc " + std::string(options.mode == MODE_RENAME ? "-x" : "k=" + std::to_string(options.k));
+    std::string output;
+    bool hit = false;
+    {
+        PhaseStats::Scope phase(stats, "cache");
+        hit = cache.lookup(options.filename, key, output);
+    }
+    if (hit) {
+        std::cout.write(output.data(), output.size());
+        std::cout.flush();
+        stats.print(std::cerr, options.statsJson);
+        return 0;
+    }
+    if (!cache.keyed()) {
+        int status = run(options, stats, std::cout, std::cerr);
+        stats.print(std::cerr, options.statsJson);
+        return status;
+    }
+
+    // keep what the run prints; only a clean run (status 0, nothing on
+    // stderr) is worth replaying
+    std::ostringstream captured, errors;
+    std::streambuf* out = std::cout.rdbuf(captured.rdbuf());
+    std::streambuf* err = std::cerr.rdbuf(errors.rdbuf());
+    int status = run(options, stats, std::cout, std::cerr);
+    std::cout.rdbuf(out);
+    std::cerr.rdbuf(err);
+
+    output = captured.str();
+    std::cout.write(output.data(), output.size());
+    std::cout.flush();
+    std::cerr << errors.str();
+    if (status == 0 && errors.str().empty()) {
+        PhaseStats::Scope phase(stats, "cache");
+        cache.store(output);
+    }
+    stats.print(std::cerr, options.statsJson);
+    return status;
+}
@@ -12,7 +12,7 @@ public:
     //rename registers
     void rename(IRNode* head);
 
-    void printRenamedIR(IRNode* head); // -x flag
+    void printRenamedIR(IRNode* head, std::ostream& out = std::cout); // -x flag
 
     void reset(); //reset renamer state
 
@@ -23,5 +23,5 @@ private:
     // helpers
     int getNewRegister(int oldReg);
     void processInstruction(IRNode* node);
-    void printInstruction(IRNode* node);
+    void printInstruction(IRNode* node, std::ostream& out);
 };
\ No newline at end of file
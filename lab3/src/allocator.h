@@ -0,0 +1,66 @@
+#pragma once
+
+#include "parser.h"
+#include <vector>
+#include <unordered_map>
+#include <climits>
+#include <ostream>
+
+// Tracks the state of a physical register
+struct PhysicalRegister {
+    int allocatedVirtualRegister;   // -1 indicates free register
+    int nextUseDistance;    // Distance to next use 
+};
+
+class RegisterAllocator {
+public:
+    explicit RegisterAllocator(int registerCount); //constructor
+
+    // back to the state of a new allocator for registerCount registers,
+    // keeping the memory already allocated
+    void reset(int registerCount);
+    
+    // main allocate function; returns the allocated block as a new IR list
+    // (owned by the allocator) whose sr/vr/pr fields all hold physical registers
+    IRNode* allocateRegisters(IRNode* instructionList);
+
+    // write the allocated block as ILOC text in a single write
+    void printAllocatedCode(std::ostream& out) const;
+
+private:
+    int registerCount;  // physical registers available
+    std::vector<PhysicalRegister> physicalRegisters;    // state of each physical register
+    std::unordered_map<int, int> virtualToPhysicalMap;  // map virtual register -> physical register
+    std::unordered_map<int, int> spillLocationMap;  // map virtual register -> memory spill address
+    int nextSpillAddress;   // next address for spills
+    std::vector<IRNode> allocatedInstructions;  // allocator output, in order
+
+    // allocation helpers
+    int getScratchRegisterIndex() const;    // registerCount - 1
+    void computeFurthestNextUse(IRNode* instructionList); 
+    int getOrAssignSpillAddress(int virtualRegister);      
+    
+    // physical register management
+    void releasePhysicalRegister(int physicalRegister);
+    int findFreePhysicalRegister();
+    int findRegisterWithFurthestNextUse(int excludedRegister1, int excludedRegister2);
+    
+    // spill and restore operations
+    void generateSpillCode(int physicalRegister, std::vector<IRNode>& outputBuffer);
+    void generateRestoreCode(int virtualRegister, int physicalRegister, std::vector<IRNode>& outputBuffer);
+    
+    // operand preparation
+    int prepareSourceOperand(int virtualRegister, int nextUseDistance, int lockedRegister1, int lockedRegister2, std::vector<IRNode>& outputBuffer);
+    int prepareSourceOperandWithScratch(int virtualRegister, int nextUseDistance, int lockedRegister, std::vector<IRNode>& outputBuffer);
+    void bindDestination(int physicalRegister, int virtualRegister, int nextUseDistance);
+    int prepareDestinationOperand(int lockedRegister1, int lockedRegister2, std::vector<IRNode>& outputBuffer);
+
+    // cleanup of the finished output: drops loadIs of a value the register
+    // already holds, reloads of a slot the register was just spilled from,
+    // ops that copy a register onto itself and loadIs nothing reads
+    void peephole();
+
+    // output helpers
+    static IRNode makeInstruction(TokenType opcode, int constant, int source1, int source2, int destination);
+    void emitInstruction(const IRNode& instruction) { allocatedInstructions.push_back(instruction); }
+};
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "batch.h"
+#include <algorithm>
+#include <deque>
+#include <dirent.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+
+static bool isInputName(const std::string& name) {
+    auto endsWith = [&name](const std::string& suffix) {
+        return name.size() > suffix.size() &&
+               name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return endsWith(".i") || endsWith(".ilir");
+}
+
+std::vector<std::string> collectBatchInputs(const std::vector<std::string>& paths, std::string& error) {
+    std::vector<std::pair<off_t, std::string>> inputs;
+    for (const std::string& path : paths) {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            error = "Could not open file " + path;
+            return {};
+        }
+        if (!S_ISDIR(info.st_mode)) {
+            inputs.push_back({info.st_size, path});
+            continue;
+        }
+
+        DIR* dir = opendir(path.c_str());
+        if (!dir) {
+            error = "Could not open directory " + path;
+            return {};
+        }
+        while (dirent* item = readdir(dir)) {
+            std::string name = item->d_name;
+            if (!isInputName(name)) continue;
+            std::string file = path + "/" + name;
+            if (stat(file.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+                inputs.push_back({info.st_size, file});
+        }
+        closedir(dir);
+    }
+
+    std::sort(inputs.begin(), inputs.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    std::vector<std::string> files;
+    for (auto& input : inputs) files.push_back(std::move(input.second));
+    return files;
+}
+
+void runWorkStealing(size_t count, int threads, const std::function<void(size_t)>& task) {
+    threads = (int)std::max<size_t>(1, std::min<size_t>(threads, count));
+
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+    std::vector<WorkQueue> queues(threads);
+    for (size_t i = 0; i < count; i++)
+        queues[i % threads].tasks.push_back(i);
+
+    // no task adds work, so once every queue is empty the worker is done
+    auto worker = [&](int self) {
+        for (;;) {
+            size_t next = 0;
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> guard(queues[self].lock);
+                if (!queues[self].tasks.empty()) {
+                    next = queues[self].tasks.front();
+                    queues[self].tasks.pop_front();
+                    found = true;
+                }
+            }
+            for (int k = 1; k < threads && !found; k++) {
+                WorkQueue& victim = queues[(self + k) % threads];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if (!victim.tasks.empty()) {
+                    next = victim.tasks.back();
+                    victim.tasks.pop_back();
+                    found = true;
+                }
+            }
+            if (!found) return;
+            task(next);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& thread : pool) thread.join();
+}
+
+void printTaskDiagnostics(std::ostream& out, const std::string& input, const std::string& text) {
+    std::string prefixed;
+    for (size_t start = 0; start < text.size(); ) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) end = text.size() - 1;
+        prefixed += input + ": " + text.substr(start, end - start + 1);
+        start = end + 1;
+    }
+    if (!prefixed.empty() && prefixed.back() != '\n') prefixed += '\n';
+    out << prefixed << std::flush;
+}
@@ -0,0 +1,254 @@
+// Microbenchmarks for the passes behind `schedule`. `make bench` builds this
+// and runs it over ilocgen blocks of increasing size. Every fixture reports
+// its best time per ILOC op at each size, and the exponent of a power-law
+// fit of time against block size: about 1 for a linear pass, 2 for one that
+// has gone quadratic.
+
+#include "parser.h"
+#include "renamer.h"
+#include "scheduler.h"
+#include "allocator.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static void freeIR(IRNode* head) {
+    while (head) {
+        IRNode* next = head->next;
+        delete head;
+        head = next;
+    }
+}
+
+// the blocks are read into memory once, so no fixture times file I/O
+static bool readFile(const std::string& path, std::string& text) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open()) return false;
+    std::ostringstream contents;
+    contents << input.rdbuf();
+    text = contents.str();
+    return true;
+}
+
+static IRNode* parseBlock(const std::string& block) {
+    Scanner scanner(block.data(), block.size());
+    Parser parser(scanner);
+    return parser.parseAll();
+}
+
+static IRNode* parseAndRename(const std::string& block) {
+    IRNode* head = parseBlock(block);
+    RegisterRenamer renamer;
+    renamer.rename(head);
+    return head;
+}
+
+// one run of a fixture on the text of a block: set up untimed, time the
+// pass alone, tear down
+using Fixture = std::function<double(const std::string& block)>;
+
+static double benchScan(const std::string& block) {
+    Clock::time_point start = Clock::now();
+    Scanner scanner(block.data(), block.size());
+    while (scanner.nextToken().type != TOKEN_EOF) {}
+    return elapsedNs(start);
+}
+
+static double benchParse(const std::string& block) {
+    Clock::time_point start = Clock::now();
+    IRNode* head = parseBlock(block);
+    double ns = elapsedNs(start);
+    freeIR(head);
+    return ns;
+}
+
+static double benchRename(const std::string& block) {
+    IRNode* head = parseBlock(block);
+    Clock::time_point start = Clock::now();
+    RegisterRenamer renamer;
+    renamer.rename(head);
+    double ns = elapsedNs(start);
+    freeIR(head);
+    return ns;
+}
+
+static Fixture benchAllocate(int k) {
+    return [k](const std::string& block) {
+        IRNode* head = parseAndRename(block);
+        double ns = 0;
+        {
+            RegisterAllocator allocator(k);
+            Clock::time_point start = Clock::now();
+            allocator.allocateRegisters(head);
+            ns = elapsedNs(start);
+        }
+        freeIR(head);
+        return ns;
+    };
+}
+
+static double benchGraph(const std::string& block) {
+    IRNode* head = parseAndRename(block);
+    DependencyGraph graph;
+    Clock::time_point start = Clock::now();
+    graph.build(head);
+    double ns = elapsedNs(start);
+    freeIR(head);
+    return ns;
+}
+
+static double benchPriorities(const std::string& block) {
+    IRNode* head = parseAndRename(block);
+    DependencyGraph graph;
+    graph.build(head);
+    Clock::time_point start = Clock::now();
+    graph.computePriorities();
+    double ns = elapsedNs(start);
+    freeIR(head);
+    return ns;
+}
+
+static double benchSchedule(const std::string& block) {
+    IRNode* head = parseAndRename(block);
+    DependencyGraph graph;
+    graph.build(head);
+    graph.computePriorities();
+    Clock::time_point start = Clock::now();
+    Scheduler(graph).schedule();
+    double ns = elapsedNs(start);
+    freeIR(head);
+    return ns;
+}
+
+// best of at least three runs, and of as many as fit in minMs
+static double bestNs(const Fixture& fixture, const std::string& block, double minMs) {
+    double best = 0, total = 0;
+    for (int run = 0; run < 3 || (total < minMs * 1e6 && run < 10000); run++) {
+        double ns = fixture(block);
+        total += ns;
+        if (run == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+// least-squares slope of log(time) against log(ops)
+static double scalingExponent(const std::vector<int>& ops, const std::vector<double>& ns) {
+    size_t n = ops.size();
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (size_t i = 0; i < n; i++) {
+        double x = std::log((double)ops[i]), y = std::log(ns[i]);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    double denominator = n * sxx - sx * sx;
+    return denominator > 0 ? (n * sxy - sx * sy) / denominator : 0.0;
+}
+
+static void printUsage() {
+    std::cerr << "Usage: schedule_bench [--min-ms <n>] [--max-exponent <x>] <file>..." << std::endl;
+    std::cerr << "  Time each pass on every file, smallest block first; exit with 1 if a" << std::endl;
+    std::cerr << "  pass scales worse than ops^<x>" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    double minMs = 200;
+    double maxExponent = 0;   // 0 = report only
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--min-ms" || arg == "--max-exponent") && i + 1 < argc) {
+            try {
+                (arg == "--min-ms" ? minMs : maxExponent) = std::stod(argv[++i]);
+            } catch (std::exception&) {
+                printUsage();
+                return 1;
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            printUsage();
+            return 1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<std::string> blocks(files.size());
+    std::vector<int> ops;
+    for (size_t i = 0; i < files.size(); i++) {
+        const std::string& file = files[i];
+        if (!readFile(file, blocks[i])) {
+            std::cerr << "Error: Could not open file " << file << std::endl;
+            return 1;
+        }
+        IRNode* head = parseBlock(blocks[i]);
+        int count = 0;
+        for (IRNode* node = head; node; node = node->next) count++;
+        freeIR(head);
+        if (count == 0) {
+            std::cerr << "Error: " << file << " holds no ops" << std::endl;
+            return 1;
+        }
+        ops.push_back(count);
+    }
+
+    const std::pair<const char*, Fixture> fixtures[] = {
+        {"Scanner::nextToken", benchScan},
+        {"Parser::parseAll", benchParse},
+        {"RegisterRenamer::rename", benchRename},
+        {"allocateRegisters k=3", benchAllocate(3)},
+        {"allocateRegisters k=8", benchAllocate(8)},
+        {"allocateRegisters k=32", benchAllocate(32)},
+        {"DependencyGraph::build", benchGraph},
+        {"computePriorities", benchPriorities},
+        {"Scheduler::schedule", benchSchedule},
+    };
+
+    char cell[64];
+    std::printf("%-24s", "ns/op at ops =");
+    for (int count : ops) {
+        std::snprintf(cell, sizeof cell, "%d", count);
+        std::printf(" %10s", cell);
+    }
+    std::printf(" %9s\n", "exponent");
+
+    int failures = 0;
+    for (const auto& [name, fixture] : fixtures) {
+        std::vector<double> ns;
+        std::printf("%-24s", name);
+        std::fflush(stdout);
+        for (size_t i = 0; i < files.size(); i++) {
+            ns.push_back(bestNs(fixture, blocks[i], minMs));
+            std::printf(" %10.2f", ns.back() / ops[i]);
+            std::fflush(stdout);
+        }
+
+        double exponent = files.size() > 1 ? scalingExponent(ops, ns) : 1.0;
+        bool tooSlow = maxExponent > 0 && exponent > maxExponent;
+        if (tooSlow) failures++;
+        std::printf(" %9.2f%s\n", exponent, tooSlow ? "  superlinear" : "");
+    }
+
+    if (failures) {
+        std::cerr << failures << " pass(es) scale worse than ops^" << maxExponent << std::endl;
+        return 1;
+    }
+    return 0;
+}
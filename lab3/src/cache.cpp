@@ -0,0 +1,210 @@
+#include "cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static uint64_t mergeRound64(uint64_t acc, uint64_t val) {
+    acc ^= round64(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+// little-endian reads; the hash names files, so it only has to agree with
+// itself on one machine
+uint64_t xxhash64(const void* data, size_t length, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + length;
+    uint64_t h;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = mergeRound64(h, v1);
+        h = mergeRound64(h, v2);
+        h = mergeRound64(h, v3);
+        h = mergeRound64(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += length;
+
+    while (p + 8 <= end) {
+        h ^= round64(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+static bool readFile(const std::string& path, std::string& contents) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    // st_size only holds for a regular file; the bytes of a pipe read here
+    // would be gone before the tool read it
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return false;
+    }
+    contents.resize(info.st_size);
+    size_t done = 0;
+    while (done < contents.size()) {
+        ssize_t n = read(fd, &contents[done], contents.size() - done);
+        if (n <= 0) break;
+        done += n;
+    }
+    close(fd);
+    contents.resize(done);
+    return done == (size_t)info.st_size;
+}
+
+// a rebuilt tool must not serve what the old one cached
+static std::string executableIdentity() {
+    struct stat info;
+    if (stat("/proc/self/exe", &info) != 0) return "unknown";
+    return std::to_string(info.st_size) + ":" + std::to_string(info.st_mtim.tv_sec) + "." +
+           std::to_string(info.st_mtim.tv_nsec);
+}
+
+ResultCache::ResultCache(const std::string& directory, uint64_t maxBytes)
+    : directory(directory), maxBytes(maxBytes) {}
+
+bool ResultCache::lookup(const std::string& inputFile, const std::string& options, std::string& output) {
+    std::string input;
+    if (!readFile(inputFile, input)) return false;  // the tool reports the bad input
+
+    std::string key = options + " exe=" + executableIdentity();
+    uint64_t hash = xxhash64(input.data(), input.size(), xxhash64(key.data(), key.size(), 0));
+    char name[17];
+    std::snprintf(name, sizeof name, "%016llx", (unsigned long long)hash);
+    entryPath = directory + "/" + name;
+    header = "iloc-cache 1\n" + key + "\n" + std::to_string(input.size()) + "\n";
+
+    std::string entry;
+    if (!readFile(entryPath, entry) || entry.compare(0, header.size(), header) != 0)
+        return false;
+
+    utimensat(AT_FDCWD, entryPath.c_str(), nullptr, 0);  // most recently used
+    output.assign(entry, header.size(), std::string::npos);
+    return true;
+}
+
+void ResultCache::store(const std::string& output) {
+    if (entryPath.empty() || header.size() + output.size() > maxBytes) return;
+
+    // make the directory and any missing parents
+    for (size_t slash = directory.find('/', 1); ; slash = directory.find('/', slash + 1)) {
+        mkdir(directory.substr(0, slash).c_str(), 0777);
+        if (slash == std::string::npos) break;
+    }
+
+    std::string temporary = directory + "/tmp." + std::to_string(getpid()) + "." + entryPath.substr(entryPath.size() - 16);
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        out << header << output;
+        if (!out) {
+            out.close();
+            unlink(temporary.c_str());
+            return;
+        }
+    }
+    if (rename(temporary.c_str(), entryPath.c_str()) != 0) {
+        unlink(temporary.c_str());
+        return;
+    }
+    evict();
+}
+
+void ResultCache::evict() {
+    struct Entry {
+        std::string path;
+        uint64_t bytes;
+        struct timespec used;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return;
+    while (dirent* item = readdir(dir)) {
+        std::string name = item->d_name;
+        if (name.size() != 16 || name.find_first_not_of("0123456789abcdef") != std::string::npos)
+            continue;  // temporaries and anything else that is not an entry
+        std::string path = directory + "/" + name;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) continue;
+        entries.push_back({path, (uint64_t)info.st_size, info.st_mtim});
+        total += info.st_size;
+    }
+    closedir(dir);
+
+    if (total <= maxBytes) return;
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        if (a.used.tv_sec != b.used.tv_sec) return a.used.tv_sec < b.used.tv_sec;
+        return a.used.tv_nsec < b.used.tv_nsec;
+    });
+    for (const Entry& entry : entries) {
+        if (total <= maxBytes) break;
+        if (unlink(entry.path.c_str()) == 0 || errno == ENOENT)
+            total -= entry.bytes;
+    }
+}
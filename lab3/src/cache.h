@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// XXH64 of a byte range (the xxHash 64-bit algorithm)
+uint64_t xxhash64(const void* data, size_t length, uint64_t seed);
+
+// --cache <dir>: tool output kept on disk, keyed by the bytes of the input
+// file, the options that shape the output and the executable that made it.
+// A hit reads the input once to hash it and the entry once to print it.
+//
+// Each entry is one file named by the 64-bit hash. It starts with the full
+// key, which is compared on a hit so that a hash collision reads as a
+// miss. Entries are written to a temporary file and renamed into place, so
+// a reader never sees half an entry even with several tools sharing the
+// directory. A hit refreshes the entry's mtime; once the directory holds
+// more than maxBytes, the entries used least recently are removed.
+class ResultCache {
+public:
+    ResultCache(const std::string& directory, uint64_t maxBytes);
+
+    // look up the output for this input and options; on a miss, the key
+    // is kept for store(). An input that is not a regular file is never
+    // keyed, so the tool reads it uncached
+    bool lookup(const std::string& inputFile, const std::string& options, std::string& output);
+
+    // lookup read and hashed the input, so store() has a key
+    bool keyed() const { return !entryPath.empty(); }
+
+    // save the output of the run that missed
+    void store(const std::string& output);
+
+private:
+    std::string directory;
+    uint64_t maxBytes;
+    std::string entryPath;   // "" until lookup has hashed the input
+    std::string header;      // first bytes of the entry: the full key
+
+    void evict();
+};
@@ -1,38 +1,223 @@
 #include "cli.h"
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <thread>
 
 void print_help() {
     std::cout << "Usage: schedule [option] <name>" << std::endl;
+    std::cout << "       schedule --batch [-j <n>] [option] <name>..." << std::endl;
+    std::cout << "       schedule --serve <socket> [-j <n>]" << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  -h        Print this help message" << std::endl;
-    std::cout << "  <name>    Scan, parse, and schedule the ILOC block in <name>" << std::endl;
+    std::cout << "  <name>    Scan, parse, and schedule the ILOC block in <name>; a binary" << std::endl;
+    std::cout << "            IR file (.ilir) is read without scanning or parsing" << std::endl;
+    std::cout << "  --best    Run forward and backward list scheduling with several" << std::endl;
+    std::cout << "            tie-breakers in parallel and print the shortest schedule" << std::endl;
+    std::cout << "  --budget-ms <n>" << std::endl;
+    std::cout << "            Keep searching randomly perturbed priorities on every core" << std::endl;
+    std::cout << "            for <n> milliseconds and print the shortest schedule found" << std::endl;
+    std::cout << "  -k <k>    Schedule with register pressure in mind, allocate to k" << std::endl;
+    std::cout << "            registers (3 <= k <= 64), then schedule the allocated code;" << std::endl;
+    std::cout << "            prints the variant with the fewest cycles after allocation" << std::endl;
+    std::cout << "  --verify  Simulate the schedule and the original block; report the" << std::endl;
+    std::cout << "            real cycle count, stalls, unit violations and whether the" << std::endl;
+    std::cout << "            output streams match, instead of printing the schedule" << std::endl;
+    std::cout << "  --report  Print the critical-path length, the resource bound, every" << std::endl;
+    std::cout << "            op's slack and the gap between the bound and the achieved" << std::endl;
+    std::cout << "            cycle count, instead of printing the schedule" << std::endl;
+    std::cout << "  --reassociate" << std::endl;
+    std::cout << "            Rebalance chains of add and mult whose intermediate" << std::endl;
+    std::cout << "            results are used once into trees before scheduling" << std::endl;
+    std::cout << "  --dot <file>" << std::endl;
+    std::cout << "            Also write the dependence graph to <file> in Graphviz DOT;" << std::endl;
+    std::cout << "            critical ops and edges are drawn in red" << std::endl;
+    std::cout << "  --batch   Schedule every <name> given, in parallel; a directory stands" << std::endl;
+    std::cout << "            for the .i and .ilir files in it. Each result is written next" << std::endl;
+    std::cout << "            to its input as <name>.sched" << std::endl;
+    std::cout << "  --serve <socket>" << std::endl;
+    std::cout << "            Stay running and schedule the blocks sent to the Unix socket" << std::endl;
+    std::cout << "            <socket> by schedule_client; each request carries its own" << std::endl;
+    std::cout << "            options (not --batch, --cache, --dot, --emit-ir or --stats)" << std::endl;
+    std::cout << "  -j <n>    Worker threads for --batch and --serve (default: one per core)" << std::endl;
+    std::cout << "  --emit-ir <file>" << std::endl;
+    std::cout << "            Also write the renamed block to <file> as binary IR" << std::endl;
+    std::cout << "  --cache <dir>" << std::endl;
+    std::cout << "            Keep the output in <dir>, keyed by a hash of the input" << std::endl;
+    std::cout << "            bytes and the options; an identical run prints it from there" << std::endl;
+    std::cout << "            (not with --budget-ms, --dot or --emit-ir)" << std::endl;
+    std::cout << "  --cache-size <MB>" << std::endl;
+    std::cout << "            Drop the least recently used entries once the cache holds" << std::endl;
+    std::cout << "            more than <MB> megabytes (default 256)" << std::endl;
+    std::cout << "  --stats[=json]" << std::endl;
+    std::cout << "            Print wall and CPU time, allocations and peak RSS for each" << std::endl;
+    std::cout << "            phase to stderr, as a table or as one JSON object" << std::endl;
+}
+
+// a whole argument as an int; std::stoi alone takes "10abc" as 10
+static bool parseInt(const std::string& text, int& value) {
+    try {
+        size_t used = 0;
+        value = std::stoi(text, &used);
+        return used == text.size();
+    } catch (std::exception&) {
+        return false;
+    }
 }
 
 CLIOptions parse_arguments(int argc, char* argv[]) {
     CLIOptions result;
     result.valid = true;
     result.mode = MODE_SCHEDULE;
+    result.best = false;
+    result.budgetMs = 0;
+    result.k = 0;
+    result.verify = false;
+    result.report = false;
+    result.reassociate = false;
+    result.batch = false;
+    unsigned cores = std::thread::hardware_concurrency();
+    result.jobs = cores ? (int)cores : 1;
+    result.cacheMb = 256;
+    result.stats = false;
+    result.statsJson = false;
+
+    const std::string usage = "Usage: schedule [option] <name>";
 
     if (argc < 2) {
         result.valid = false;
-        result.errorMessage = "Usage: schedule [option] <name>";
+        result.errorMessage = usage;
         return result;
     }
 
-    std::string firstArg = argv[1];
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
 
-    if (firstArg == "-h") {
-        result.mode = MODE_HELP;
-        return result;
+        if (arg == "-h") {
+            result.mode = MODE_HELP;
+            return result;
+        } else if (arg == "--best") {
+            result.best = true;
+        } else if (arg == "--verify") {
+            result.verify = true;
+        } else if (arg == "--report") {
+            result.report = true;
+        } else if (arg == "--reassociate") {
+            result.reassociate = true;
+        } else if (arg == "--batch") {
+            result.batch = true;
+        } else if (arg == "-j") {
+            if (i + 1 >= argc) {
+                result.valid = false;
+                result.errorMessage = "-j requires a number of threads";
+                return result;
+            }
+            if (!parseInt(argv[++i], result.jobs)) result.jobs = -1;
+            if (result.jobs <= 0) {
+                result.valid = false;
+                result.errorMessage = "Invalid thread count: '" + std::string(argv[i]) + "' is not a positive number.";
+                return result;
+            }
+        } else if (arg == "--serve") {
+            if (i + 1 >= argc) {
+                result.valid = false;
+                result.errorMessage = "--serve requires a socket path";
+                return result;
+            }
+            result.serveSocket = argv[++i];
+        } else if (arg == "--stats" || arg == "--stats=json") {
+            result.stats = true;
+            result.statsJson = (arg == "--stats=json");
+        } else if (arg == "--cache") {
+            if (i + 1 >= argc) {
+                result.valid = false;
+                result.errorMessage = "--cache requires a directory";
+                return result;
+            }
+            result.cacheDir = argv[++i];
+        } else if (arg == "--cache-size") {
+            if (i + 1 >= argc) {
+                result.valid = false;
+                result.errorMessage = "--cache-size requires a number of megabytes";
+                return result;
+            }
+            if (!parseInt(argv[++i], result.cacheMb)) result.cacheMb = -1;
+            if (result.cacheMb <= 0) {
+                result.valid = false;
+                result.errorMessage = "Invalid cache size: '" + std::string(argv[i]) + "' is not a positive number of megabytes.";
+                return result;
+            }
+        } else if (arg == "--emit-ir") {
+            if (i + 1 >= argc) {
+                result.valid = false;
+                result.errorMessage = "--emit-ir requires an output file name";
+                return result;
+            }
+            result.irFile = argv[++i];
+        } else if (arg == "--dot") {
+            if (i + 1 >= argc) {
+                result.valid = false;
+                result.errorMessage = "--dot requires an output file name";
+                return result;
+            }
+            result.dotFile = argv[++i];
+        } else if (arg == "--budget-ms") {
+            if (i + 1 >= argc) {
+                result.valid = false;
+                result.errorMessage = "--budget-ms requires a number of milliseconds";
+                return result;
+            }
+            if (!parseInt(argv[++i], result.budgetMs)) result.budgetMs = -1;
+            if (result.budgetMs <= 0) {
+                result.valid = false;
+                result.errorMessage = "Invalid budget: '" + std::string(argv[i]) + "' is not a positive number of milliseconds.";
+                return result;
+            }
+        } else if (arg == "-k") {
+            if (i + 1 >= argc) {
+                result.valid = false;
+                result.errorMessage = "-k requires a register count";
+                return result;
+            }
+            if (!parseInt(argv[++i], result.k)) result.k = -1;
+            if (result.k < 3 || result.k > 64) {
+                result.valid = false;
+                result.errorMessage = "Invalid register count: k must be between 3 and 64, got " + std::string(argv[i]);
+                return result;
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            result.valid = false;
+            result.errorMessage = "Unknown option: " + arg;
+            return result;
+        } else {
+            result.inputs.push_back(arg);
+        }
     }
 
-    if (argc == 2) {
-        result.filename = firstArg;
-        return result;
+    if (!result.batch && result.inputs.size() == 1)
+        result.filename = result.inputs[0];
+
+    if (!result.serveSocket.empty()) {
+        // the server takes everything but -j from each request
+        if (!result.inputs.empty() || result.batch || result.best || result.budgetMs || result.k ||
+            result.verify || result.report || result.reassociate || !result.dotFile.empty() ||
+            !result.irFile.empty() || !result.cacheDir.empty() || result.stats) {
+            result.valid = false;
+            result.errorMessage = "--serve takes only -j; the other options come with each request";
+        }
+    } else if (result.batch ? result.inputs.empty() : result.filename.empty()) {
+        result.valid = false;
+        result.errorMessage = usage;
+    } else if (result.batch && (!result.dotFile.empty() || !result.irFile.empty())) {
+        result.valid = false;
+        result.errorMessage = "--dot and --emit-ir name one file and cannot be combined with --batch";
+    } else if (result.batch && !result.cacheDir.empty()) {
+        result.valid = false;
+        result.errorMessage = "--cache cannot be combined with --batch";
+    } else if (result.verify && result.report) {
+        result.valid = false;
+        result.errorMessage = "--verify and --report cannot be combined";
     }
 
-    result.valid = false;
-    result.errorMessage = "Usage: schedule [option] <name>";
     return result;
 }
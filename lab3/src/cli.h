@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 enum Mode {
     MODE_HELP,
@@ -10,6 +11,22 @@ enum Mode {
 struct CLIOptions {
     Mode mode;
     std::string filename;
+    bool batch;         // --batch: schedule every input, files or directories
+    std::vector<std::string> inputs; // the inputs of --batch
+    int jobs;           // -j N: worker threads for --batch and --serve
+    std::string serveSocket; // --serve <socket>: answer requests on a Unix socket
+    bool best;          // --best: forward + backward, several tie-breakers
+    int budgetMs;       // --budget-ms N: randomized restarts for N ms (0 = off)
+    int k;              // -k N: allocate to N registers, then schedule (0 = off)
+    bool verify;        // --verify: simulate the schedule instead of printing it
+    bool report;        // --report: critical path, slack and gap instead of the schedule
+    bool reassociate;   // --reassociate: rebalance add/mult chains before scheduling
+    std::string dotFile; // --dot <file>: write the dependence graph in DOT
+    std::string irFile;  // --emit-ir <file>: also write the renamed block as binary IR
+    std::string cacheDir; // --cache <dir>: reuse output for identical input and options
+    int cacheMb;        // --cache-size N: bound on the cache directory in MB
+    bool stats;         // --stats: per-phase time and memory on stderr
+    bool statsJson;     // --stats=json: the same as one JSON object
     bool valid;
     std::string errorMessage;
 };
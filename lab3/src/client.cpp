@@ -0,0 +1,140 @@
+// schedule_client: send a block to a `schedule --serve` process and print
+// what it answers, or measure how many requests per second it answers.
+
+#include "server.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+static void printUsage() {
+    std::cerr << "Usage: schedule_client <socket> [option] <name>" << std::endl;
+    std::cerr << "       schedule_client <socket> --bench <seconds> [-c <n>] [option] <name>" << std::endl;
+    std::cerr << "  Send the block in <name> and the schedule options to the server on" << std::endl;
+    std::cerr << "  <socket>, print its output and exit with its status. --bench sends the" << std::endl;
+    std::cerr << "  same request over <n> connections (default 1) for <seconds> and prints" << std::endl;
+    std::cerr << "  the requests answered per second" << std::endl;
+}
+
+// --bench: every connection sends the request again as soon as the answer
+// to the last one is in
+static int runBench(const std::string& socketPath, const ServerRequest& request,
+                    double seconds, int connections) {
+    std::atomic<long> answered(0), failed(0);
+    std::atomic<double> latencyNs(0);
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::duration_cast<Clock::duration>(
+                                             std::chrono::duration<double>(seconds));
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < connections; c++) {
+        threads.emplace_back([&]() {
+            int fd = connectToServer(socketPath);
+            if (fd < 0) {
+                failed++;
+                return;
+            }
+            std::string output;
+            int status = 0;
+            double ns = 0;
+            long count = 0;
+            while (Clock::now() < deadline) {
+                Clock::time_point sent = Clock::now();
+                if (!sendRequest(fd, request) || !receiveResponse(fd, status, output)) {
+                    failed++;
+                    break;
+                }
+                ns += std::chrono::duration<double, std::nano>(Clock::now() - sent).count();
+                count++;
+                if (status != 0) failed++;
+            }
+            close(fd);
+            answered += count;
+            for (double total = latencyNs.load(); !latencyNs.compare_exchange_weak(total, total + ns);) {}
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (answered.load() == 0) {
+        std::cerr << "Error: no request was answered" << std::endl;
+        return 1;
+    }
+    std::printf("%ld requests in %.2f s over %d connection(s): %.1f requests/sec, mean latency %.3f ms\n",
+                answered.load(), elapsed, connections, answered.load() / elapsed,
+                latencyNs.load() / answered.load() / 1e6);
+    if (failed.load()) {
+        std::cerr << failed.load() << " request(s) failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printUsage();
+        return 1;
+    }
+    std::string socketPath = argv[1];
+    std::string name = argv[argc - 1];
+    double seconds = 0;   // 0 = one request
+    int connections = 1;
+
+    // everything between the socket and <name> that is not ours goes to the server
+    ServerRequest request;
+    for (int i = 2; i < argc - 1; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--bench" || arg == "-c") && i + 1 < argc - 1) {
+            try {
+                if (arg == "--bench") seconds = std::stod(argv[++i]);
+                else connections = std::stoi(argv[++i]);
+            } catch (std::exception&) {
+                printUsage();
+                return 1;
+            }
+            if (seconds < 0 || connections <= 0) {
+                printUsage();
+                return 1;
+            }
+        } else {
+            request.options.push_back(arg);
+        }
+    }
+
+    std::ifstream file(name, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << name << std::endl;
+        return 1;
+    }
+    std::ostringstream block;
+    block << file.rdbuf();
+    request.block = block.str();
+
+    if (seconds > 0) return runBench(socketPath, request, seconds, connections);
+
+    int fd = connectToServer(socketPath);
+    if (fd < 0) {
+        std::cerr << "Error: no server on " << socketPath << std::endl;
+        return 1;
+    }
+    int status = 1;
+    std::string output;
+    if (!sendRequest(fd, request) || !receiveResponse(fd, status, output)) {
+        std::cerr << "Error: the server on " << socketPath << " hung up" << std::endl;
+        close(fd);
+        return 1;
+    }
+    close(fd);
+
+    // a failed request answers with its error messages
+    std::cout.write(output.data(), output.size());
+    return status;
+}
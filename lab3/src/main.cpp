@@ -1,40 +1,487 @@
 #include "parser.h"
 #include "renamer.h"
 #include "scheduler.h"
+#include "allocator.h"
+#include "simulator.h"
+#include "reassociate.h"
+#include "irfile.h"
+#include "cache.h"
+#include "batch.h"
+#include "server.h"
+#include "stats.h"
 #include "cli.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 
-int main(int argc, char* argv[]) {
-    CLIOptions options = parse_arguments(argc, argv);
-    if (options.mode == MODE_HELP) {
-        print_help();
-        return 0;
+static void freeIR(IRNode* head) {
+    while (head) {
+        IRNode* next = head->next;
+        delete head;
+        head = next;
     }
-    if (!options.valid) {
-        std::cerr << options.errorMessage << std::endl;
+}
+
+// frees the block on every way out of run(); reassociation may replace its head
+struct IRListGuard {
+    IRNode*& head;
+    ~IRListGuard() { freeIR(head); }
+};
+
+// run the schedule variant selected on the command line
+static Schedule runScheduler(DependencyGraph& graph, const Scheduler& scheduler, const CLIOptions& options,
+                             PhaseStats& stats) {
+    if (options.best || options.budgetMs > 0) {
+        PhaseStats::Scope phase(stats, "priorities");
+        graph.computeTieBreakers();
+    }
+
+    PhaseStats::Scope phase(stats, "schedule");
+    Schedule sched = options.best ? scheduler.scheduleBest() : scheduler.schedule();
+    if (options.budgetMs > 0)
+        sched = scheduler.scheduleWithBudget(sched, options.budgetMs);
+    return sched;
+}
+
+// one -k variant: an op order, its allocation and the schedule of the allocated code
+struct AllocatedCandidate {
+    std::vector<IRNode> ops;
+    RegisterAllocator allocator;
+    DependencyGraph graph;
+    Schedule sched;
+
+    explicit AllocatedCandidate(int k) : allocator(k) {}
+};
+
+// the pass objects a thread runs blocks with. The CLI makes one per run;
+// --batch and --serve keep one per worker thread (runWarm), so a request
+// starts with the node pools, tables and buffers earlier requests grew
+// instead of allocating them again
+struct PassWorkspace {
+    RegisterRenamer renamer;
+    TreeHeightReducer reducer;
+    Simulator simulator;
+    DependencyGraph graph;
+    std::vector<std::unique_ptr<AllocatedCandidate>> candidates;   // -k
+
+    // candidate i, reset for k registers
+    AllocatedCandidate& candidate(size_t i, int k) {
+        if (candidates.size() <= i) candidates.push_back(std::make_unique<AllocatedCandidate>(k));
+        AllocatedCandidate& reused = *candidates[i];
+        reused.ops.clear();
+        reused.allocator.reset(k);
+        reused.sched.clear();
+        return reused;
+    }
+};
+
+static void allocateAndSchedule(AllocatedCandidate& candidate, const std::vector<IRNode*>& order,
+                                const CLIOptions& options, PhaseStats& stats) {
+    IRNode* allocated = nullptr;
+    {
+        PhaseStats::Scope phase(stats, "allocate");
+        // the allocator annotates its input, so each candidate works on its own copy
+        candidate.ops.reserve(order.size());
+        for (IRNode* node : order) candidate.ops.push_back(*node);
+        IRNode* previous = nullptr;
+        for (auto& node : candidate.ops) {
+            node.prev = previous;
+            node.next = nullptr;
+            if (previous) previous->next = &node;
+            previous = &node;
+        }
+        allocated = candidate.allocator.allocateRegisters(candidate.ops.empty() ? nullptr : &candidate.ops.front());
+    }
+    if (!allocated) return;
+
+    {
+        PhaseStats::Scope phase(stats, "graph");
+        candidate.graph.build(allocated);
+    }
+    {
+        PhaseStats::Scope phase(stats, "priorities");
+        candidate.graph.computePriorities();
+    }
+    Scheduler scheduler(candidate.graph);
+    candidate.sched = runScheduler(candidate.graph, scheduler, options, stats);
+}
+
+// ops in the order a schedule issues them (f0 before f1 within a cycle)
+static std::vector<IRNode*> issueOrder(const Schedule& sched) {
+    std::vector<IRNode*> order;
+    for (const Bundle& bundle : sched) {
+        for (SchedulerNode* node : bundle) {
+            if (node) order.push_back(node->ir);
+        }
+    }
+    return order;
+}
+
+// --verify: compare what the schedule prints with a sequential run of the
+// original block
+static int verifySchedule(Simulator& sim, const SimReport& reference, const Schedule& sched, std::ostream& out) {
+    SimReport run = sim.runSchedule(sched);
+
+    out << "original:  " << reference.ops << " ops, "
+        << reference.output.size() << " output values" << std::endl;
+    if (!reference.ok) {
+        out << "original block faulted: " << reference.error << std::endl;
+        return 1;
+    }
+
+    out << "schedule:  " << run.ops << " ops in " << run.cycles << " cycles ("
+        << run.stallCycles << " stall cycles), last result in cycle "
+        << run.completionCycle << std::endl;
+    if (!run.ok) {
+        out << "schedule faulted: " << run.error << std::endl;
         return 1;
     }
 
-    Scanner scanner(options.filename);
-    Parser parser(scanner);
-    IRNode* head = parser.parseAll();
+    bool valid = true;
+    if (run.unitViolations || run.outputViolations) {
+        out << "violations: " << run.unitViolations << " ops on the wrong unit, "
+            << run.outputViolations << " cycles with two outputs" << std::endl;
+        valid = false;
+    }
+    if (run.lateWrites) {
+        out << "write order: " << run.lateWrites << " results landed after a later op's result "
+            << "to the same register or word" << std::endl;
+        valid = false;
+    }
+    if (run.stallCycles) {
+        out << "latencies not respected: the schedule only runs with interlocks" << std::endl;
+        valid = false;
+    }
+    if (run.output != reference.output) {
+        size_t i = 0;
+        while (i < run.output.size() && i < reference.output.size() && run.output[i] == reference.output[i])
+            i++;
+        out << "output streams differ at value " << i + 1 << std::endl;
+        valid = false;
+    } else {
+        out << "output streams match" << std::endl;
+    }
+
+    out << (valid ? "PASS" : "FAIL") << std::endl;
+    return valid ? 0 : 1;
+}
+
+// the whole pipeline for one block; diagnostics go to errors. `request`,
+// from --serve, holds the block itself instead of options.filename. For
+// --serve and --batch a block with syntax errors is rejected rather than
+// scheduled in part
+static int run(const CLIOptions& options, PassWorkspace& work, PhaseStats& stats, std::ostream& out,
+               std::ostream& errors, const std::string* request = nullptr) {
+    IRNode* head = nullptr;
+    IRListGuard guard{head};
+    bool binary = request ? request->compare(0, sizeof IR_FILE_MAGIC, IR_FILE_MAGIC, sizeof IR_FILE_MAGIC) == 0
+                          : IRFile::isIRFile(options.filename);
+    bool renamed = false;
+    if (binary) {
+        PhaseStats::Scope phase(stats, "read-ir");
+        std::unique_ptr<IRFile> file = request ? std::make_unique<IRFile>(request->data(), request->size())
+                                               : std::make_unique<IRFile>(options.filename);
+        if (!file->ok()) {
+            errors << "Error: " << file->error() << std::endl;
+            return 1;
+        }
+        head = file->toList();
+        renamed = file->renamed();
+    } else if (request) {
+        PhaseStats::Scope phase(stats, "scan+parse");
+        Scanner scanner(request->data(), request->size());
+        Parser parser(scanner);
+        parser.setDiagnostics(errors);
+        head = parser.parseAll();
+        if (parser.hasErrors()) return 1;
+    } else {
+        PhaseStats::Scope phase(stats, "scan+parse");
+        Scanner scanner(options.filename);
+        Parser parser(scanner);
+        if (options.batch) parser.setDiagnostics(errors);
+        head = parser.parseAll();
+        if (options.batch && parser.hasErrors()) return 1;
+    }
 
     if (!head) {
         return 0;
     }
 
     // Lab 3 requires register renaming (Lab 2) first
-    RegisterRenamer renamer;
-    renamer.rename(head);
+    if (!renamed) {
+        PhaseStats::Scope phase(stats, "rename");
+        work.renamer.rename(head);
+    }
+
+    if (!options.irFile.empty()) {
+        PhaseStats::Scope phase(stats, "emit-ir");
+        std::string error;
+        if (!writeIRFile(options.irFile, head, true, binary ? "" : options.filename, error)) {
+            errors << "Error: " << error << std::endl;
+            return 1;
+        }
+    }
+
+    // the reference run sees the block before any rewriting
+    SimReport reference;
+    if (options.verify) {
+        PhaseStats::Scope phase(stats, "simulate");
+        reference = work.simulator.runSequential(head);
+    }
+
+    if (options.reassociate) {
+        PhaseStats::Scope phase(stats, "reassociate");
+        head = work.reducer.reduce(head);
+    }
 
     // Build Dependency Graph
-    DependencyGraph graph;
-    graph.build(head);
-    graph.computePriorities();
+    DependencyGraph& graph = work.graph;
+    {
+        PhaseStats::Scope phase(stats, "graph");
+        graph.build(head);
+    }
+    {
+        PhaseStats::Scope phase(stats, "priorities");
+        graph.computePriorities();
+    }
 
     // Schedule
     Scheduler scheduler(graph);
-    scheduler.schedule();
 
+    // the graph and schedule that get printed, verified or reported
+    DependencyGraph* finalGraph = &graph;
+    Schedule sched;
+    AllocatedCandidate* best = nullptr;
+
+    if (options.k == 0) {
+        sched = runScheduler(graph, scheduler, options, stats);
+    } else {
+        // -k: what counts is the cycle count after allocation, so allocate the
+        // original order, the plain schedule and pressure-aware schedules and
+        // keep whichever schedules shortest once spill code is in place
+        std::vector<IRNode*> original;
+        for (IRNode* node = head; node; node = node->next)
+            original.push_back(node);
+
+        std::vector<std::vector<IRNode*>> orders;
+        {
+            PhaseStats::Scope phase(stats, "schedule");
+            orders.push_back(original);
+            orders.push_back(issueOrder(scheduler.schedule()));
+            // one register is the allocator's scratch, so the limit starts at k-1;
+            // the allocator spills best a little under that, and the further
+            // under the smaller k is, so a few limits are tried
+            for (int limit = options.k - 1; limit >= std::max(2, options.k - 3); limit--)
+                orders.push_back(issueOrder(scheduler.schedulePressure(limit)));
+        }
+
+        for (size_t i = 0; i < orders.size(); i++) {
+            AllocatedCandidate& candidate = work.candidate(i, options.k);
+            allocateAndSchedule(candidate, orders[i], options, stats);
+            if (!best || candidate.sched.size() < best->sched.size())
+                best = &candidate;
+        }
+        finalGraph = &best->graph;
+        sched = best->sched;
+    }
+
+    int criticalPath = 0;
+    if (options.report || !options.dotFile.empty()) {
+        PhaseStats::Scope phase(stats, "slack");
+        criticalPath = finalGraph->computeSlack();
+    }
+
+    if (!options.dotFile.empty()) {
+        PhaseStats::Scope phase(stats, "emit");
+        std::ofstream dot(options.dotFile);
+        if (!dot) {
+            errors << "Error: Could not open file " << options.dotFile << std::endl;
+            return 1;
+        }
+        finalGraph->writeDot(dot);
+    }
+
+    if (options.verify) {
+        PhaseStats::Scope phase(stats, "verify");
+        return verifySchedule(work.simulator, reference, sched, out);
+    }
+
+    PhaseStats::Scope phase(stats, "emit");
+    if (options.report) {
+        Scheduler(*finalGraph).printReport(sched, criticalPath, out);
+        return 0;
+    }
+    Scheduler(*finalGraph).printSchedule(sched, out);
     return 0;
 }
+
+// a worker keeps its workspace warm between blocks of up to this many ops;
+// after a bigger one it gives the memory back rather than hold it idle
+static constexpr size_t WARM_BLOCK_OPS = 1 << 14;
+
+// run() with the calling thread's workspace
+static int runWarm(const CLIOptions& options, PhaseStats& stats, std::ostream& out,
+                   std::ostream& errors, const std::string* request = nullptr) {
+    thread_local std::unique_ptr<PassWorkspace> work;
+    if (!work) work = std::make_unique<PassWorkspace>();
+    int status = run(options, *work, stats, out, errors, request);
+    if (work->graph.nodes.size() > WARM_BLOCK_OPS) work.reset();
+    return status;
+}
+
+// --batch: schedule every input on a work-stealing pool; each result goes
+// next to its input. A task's diagnostics go to stderr once it finishes,
+// prefixed with its input; a failed task leaves no result behind
+static int runBatch(const CLIOptions& options) {
+    std::string error;
+    std::vector<std::string> inputs = collectBatchInputs(options.inputs, error);
+    if (!error.empty()) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+    std::atomic<int> failed(0);
+    runWorkStealing(inputs.size(), options.jobs, [&](size_t i) {
+        CLIOptions single = options;
+        single.filename = inputs[i];
+        std::string result = single.filename + ".sched";
+        PhaseStats quiet("schedule", false);
+        std::ostringstream errors;
+        int status = 1;
+        try {
+            // the Scanner exits on a file it cannot open, so check first
+            if (!std::ifstream(single.filename).is_open()) {
+                errors << "Error: Could not open file" << std::endl;
+            } else {
+                std::ofstream out(result, std::ios::binary);
+                if (!out.is_open()) {
+                    errors << "Error: Could not open file " << result << std::endl;
+                } else {
+                    status = runWarm(single, quiet, out, errors);
+                    if (!out.flush()) status = 1;
+                    out.close();
+                    if (status != 0) std::remove(result.c_str());
+                }
+            }
+        } catch (const std::exception& e) {
+            errors << "Error: " << e.what() << std::endl;
+            std::remove(result.c_str());
+        }
+        printTaskDiagnostics(std::cerr, single.filename, errors.str());
+        if (status != 0) failed++;
+    });
+
+    std::cerr << "schedule: " << inputs.size() << " files, " << failed.load() << " failed" << std::endl;
+    return failed.load() ? 1 : 0;
+}
+
+// --serve: one request is the options of a command line plus the block
+// that <name> would have held
+static int serveRequest(const ServerRequest& request, std::ostream& out) {
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>("schedule"));
+    for (const std::string& option : request.options)
+        argv.push_back(const_cast<char*>(option.c_str()));
+    argv.push_back(const_cast<char*>("<request>"));
+
+    CLIOptions options = parse_arguments((int)argv.size(), argv.data());
+    if (options.mode == MODE_HELP || !options.valid) {
+        out << (options.valid ? "-h is not a request" : options.errorMessage) << '\n';
+        return 1;
+    }
+    if (options.batch || !options.serveSocket.empty() || !options.dotFile.empty() ||
+        !options.irFile.empty() || !options.cacheDir.empty() || options.stats) {
+        out << "--batch, --serve, --dot, --emit-ir, --cache and --stats are not available to a request\n";
+        return 1;
+    }
+
+    PhaseStats quiet("schedule", false);
+    return runWarm(options, quiet, out, out, &request.block);
+}
+
+int main(int argc, char* argv[]) {
+    CLIOptions options = parse_arguments(argc, argv);
+    if (options.mode == MODE_HELP) {
+        print_help();
+        return 0;
+    }
+    if (!options.valid) {
+        std::cerr << options.errorMessage << std::endl;
+        return 1;
+    }
+
+    if (!options.serveSocket.empty())
+        return serve(options.serveSocket, options.jobs, serveRequest);
+
+    PhaseStats stats("schedule", options.stats);
+
+    if (options.batch) {
+        int status = 0;
+        {
+            PhaseStats::Scope phase(stats, "batch");
+            status = runBatch(options);
+        }
+        stats.print(std::cerr, options.statsJson);
+        return status;
+    }
+
+    PassWorkspace work;
+
+    // a budgeted search depends on the clock, and --dot and --emit-ir
+    // write files the cache does not keep
+    bool cacheable = !options.cacheDir.empty() && options.budgetMs == 0 &&
+                     options.dotFile.empty() && options.irFile.empty();
+    if (!cacheable) {
+        int status = run(options, work, stats, std::cout, std::cerr);
+        stats.print(std::cerr, options.statsJson);
+        return status;
+    }
+
+    ResultCache cache(options.cacheDir, (uint64_t)options.cacheMb << 20);
+    std::string key = "schedule k=" + std::to_string(options.k) +
+                      " best=" + std::to_string(options.best) +
+                      " verify=" + std::to_string(options.verify) +
+                      " report=" + std::to_string(options.report) +
+                      " reassociate=" + std::to_string(options.reassociate);
+    std::string output;
+    bool hit = false;
+    {
+        PhaseStats::Scope phase(stats, "cache");
+        hit = cache.lookup(options.filename, key, output);
+    }
+    if (hit) {
+        std::cout.write(output.data(), output.size());
+        std::cout.flush();
+        stats.print(std::cerr, options.statsJson);
+        return 0;
+    }
+    if (!cache.keyed()) {
+        int status = run(options, work, stats, std::cout, std::cerr);
+        stats.print(std::cerr, options.statsJson);
+        return status;
+    }
+
+    // keep what the run prints; only a clean run (status 0, nothing on
+    // stderr) is worth replaying
+    std::ostringstream captured, errors;
+    std::streambuf* out = std::cout.rdbuf(captured.rdbuf());
+    std::streambuf* err = std::cerr.rdbuf(errors.rdbuf());
+    int status = run(options, work, stats, std::cout, std::cerr);
+    std::cout.rdbuf(out);
+    std::cerr.rdbuf(err);
+
+    output = captured.str();
+    std::cout.write(output.data(), output.size());
+    std::cout.flush();
+    std::cerr << errors.str();
+    if (status == 0 && errors.str().empty()) {
+        PhaseStats::Scope phase(stats, "cache");
+        cache.store(output);
+    }
+    stats.print(std::cerr, options.statsJson);
+    return status;
+}
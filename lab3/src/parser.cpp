@@ -22,7 +22,7 @@ bool Parser::expect(TokenType expected, const std::string& errorMessage) {
         lookahead = scanner.nextToken();
         return true;
     } else {
-        std::cerr << "Error (line " << lookahead.line << "): " << errorMessage << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): " << errorMessage << std::endl;
         return false;
     }
 }
@@ -74,7 +74,7 @@ void Parser::skiptoEOL() {
 
 // main parse function
 IRNode* Parser::parseAll() {
-    bool hasError = false;
+    hasError = false;
 
     while (lookahead.type != TOKEN_EOF) {
         // skip empty lines
@@ -91,7 +91,7 @@ IRNode* Parser::parseAll() {
     }
 
     if (hasError) {
-        std::cout << "Errors detected" << std::endl;
+        *summaryStream << "Errors detected" << std::endl;
         return head; //return partial IR
     }
 
@@ -138,7 +138,7 @@ bool Parser::parseOperation() {
             break;
 
         default: // unexpected token
-            std::cerr << "Error (line " << lookahead.line << "): Unexpected token " 
+            *errorStream << "Error (line " << lookahead.line << "): Unexpected token " 
                       << lookahead.lexeme << std::endl;
             delete node;
             return false;
@@ -161,7 +161,7 @@ bool Parser::parseLoad(IRNode* node) {
 
     // get source register
     if (lookahead.type != TOKEN_REGISTER) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected source register after LOAD." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected source register after LOAD." << std::endl;
         return false;
     }
     node->sr1 = getRegisterNumber(lookahead.lexeme);
@@ -174,7 +174,7 @@ bool Parser::parseLoad(IRNode* node) {
 
     // get destination register
     if (lookahead.type != TOKEN_REGISTER) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected destination register after '=>' in LOAD." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected destination register after '=>' in LOAD." << std::endl;
         return false;
     }
     node->sr3 = getRegisterNumber(lookahead.lexeme);
@@ -182,7 +182,7 @@ bool Parser::parseLoad(IRNode* node) {
 
     // expect end of line
     if (lookahead.type != TOKEN_EOL && lookahead.type != TOKEN_EOF) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected end of line after LOAD operation." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected end of line after LOAD operation." << std::endl;
         return false;
     }
 
@@ -201,7 +201,7 @@ bool Parser::parseLoadI(IRNode* node) {
 
     // get constant value
     if (lookahead.type != TOKEN_CONSTANT) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected constant after LOADI." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected constant after LOADI." << std::endl;
         return false;
     }
     node->sr1 = getConstantValue(lookahead.lexeme);
@@ -214,7 +214,7 @@ bool Parser::parseLoadI(IRNode* node) {
 
     // get destination register
     if (lookahead.type != TOKEN_REGISTER) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected destination register after '=>' in LOADI." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected destination register after '=>' in LOADI." << std::endl;
         return false;
     }
     node->sr3 = getRegisterNumber(lookahead.lexeme);
@@ -222,7 +222,7 @@ bool Parser::parseLoadI(IRNode* node) {
 
     // expect end of line
     if (lookahead.type != TOKEN_EOL && lookahead.type != TOKEN_EOF) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected end of line after LOADI operation." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected end of line after LOADI operation." << std::endl;
         return false;
     }
 
@@ -241,7 +241,7 @@ bool Parser::parseStore(IRNode* node) {
 
     // get source register
     if (lookahead.type != TOKEN_REGISTER) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected source register after STORE." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected source register after STORE." << std::endl;
         return false;
     }
     node->sr1 = getRegisterNumber(lookahead.lexeme);
@@ -254,7 +254,7 @@ bool Parser::parseStore(IRNode* node) {
 
     // get destination register
     if (lookahead.type != TOKEN_REGISTER) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected destination register after '=>' in STORE." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected destination register after '=>' in STORE." << std::endl;
         return false;
     }
     node->sr3 = getRegisterNumber(lookahead.lexeme);
@@ -262,7 +262,7 @@ bool Parser::parseStore(IRNode* node) {
 
     // expect end of line
     if (lookahead.type != TOKEN_EOL && lookahead.type != TOKEN_EOF) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected end of line after STORE operation." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected end of line after STORE operation." << std::endl;
         return false;
     }
 
@@ -279,7 +279,7 @@ bool Parser::parseArithmetic(IRNode* node) {
 
     // get first source register
     if (lookahead.type != TOKEN_REGISTER) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected first source register in arithmetic operation." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected first source register in arithmetic operation." << std::endl;
         return false;
     }
     node->sr1 = getRegisterNumber(lookahead.lexeme);
@@ -292,7 +292,7 @@ bool Parser::parseArithmetic(IRNode* node) {
 
     // get second source register
     if (lookahead.type != TOKEN_REGISTER) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected second source register in arithmetic operation." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected second source register in arithmetic operation." << std::endl;
         return false;
     }
     node->sr2 = getRegisterNumber(lookahead.lexeme);
@@ -305,7 +305,7 @@ bool Parser::parseArithmetic(IRNode* node) {
 
     // get destination register
     if (lookahead.type != TOKEN_REGISTER) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected destination register in arithmetic operation." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected destination register in arithmetic operation." << std::endl;
         return false;
     }
     node->sr3 = getRegisterNumber(lookahead.lexeme);
@@ -313,7 +313,7 @@ bool Parser::parseArithmetic(IRNode* node) {
 
     // expect end of line
     if (lookahead.type != TOKEN_EOL && lookahead.type != TOKEN_EOF) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected end of line after arithmetic operation." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected end of line after arithmetic operation." << std::endl;
         return false;
     }
 
@@ -333,7 +333,7 @@ bool Parser::parseOutput(IRNode* node) {
 
     // get constant value
     if (lookahead.type != TOKEN_CONSTANT) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected constant after OUTPUT." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected constant after OUTPUT." << std::endl;
         return false;
     }
     node->sr1 = getConstantValue(lookahead.lexeme);
@@ -341,7 +341,7 @@ bool Parser::parseOutput(IRNode* node) {
 
     // expect end of line
     if (lookahead.type != TOKEN_EOL && lookahead.type != TOKEN_EOF) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected end of line after OUTPUT operation." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected end of line after OUTPUT operation." << std::endl;
         return false;
     }
 
@@ -362,7 +362,7 @@ bool Parser::parseNop(IRNode* node) {
 
     // expect end of line
     if (lookahead.type != TOKEN_EOL && lookahead.type != TOKEN_EOF) {
-        std::cerr << "Error (line " << lookahead.line << "): Expected end of line after NOP operation." << std::endl;
+        *errorStream << "Error (line " << lookahead.line << "): Expected end of line after NOP operation." << std::endl;
         return false;
     }
 
@@ -22,6 +22,11 @@ public:
     IRNode* parseAll(); // return head of IR linked list
     void printIR(); //print the IR linked list
 
+    // send syntax errors and the "Errors detected" line to `out` instead of
+    // stderr and stdout
+    void setDiagnostics(std::ostream& out) { errorStream = summaryStream = &out; }
+    bool hasErrors() const { return hasError; }
+
 private:
     Scanner& scanner;
     Token lookahead;
@@ -29,6 +34,10 @@ private:
     IRNode* head = nullptr; // head of IR linked list
     IRNode* tail = nullptr; // tail of IR linked list
 
+    bool hasError = false;
+    std::ostream* errorStream = &std::cerr;
+    std::ostream* summaryStream = &std::cout;
+
     //helper functions
     bool match(TokenType expected);
     bool expect(TokenType expected, const std::string& errorMessage);
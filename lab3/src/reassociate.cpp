@@ -0,0 +1,224 @@
+#include "reassociate.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+TreeHeightReducer::TreeHeightReducer() : nextVR(0), rebuilt(0) {}
+
+int TreeHeightReducer::latencyOf(TokenType opcode) {
+    switch (opcode) {
+        case TOKEN_LOAD:
+        case TOKEN_STORE:
+            return 5;
+        case TOKEN_MULT:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// renameDefinitions — the renamer maps each source register to one VR, so
+// a VR is overwritten whenever its register is. Give every definition a
+// VR of its own (live-in values keep one VR each) and count the reads of
+// each, which is the single-use test the rebuild needs.
+// ---------------------------------------------------------------------------
+void TreeHeightReducer::renameDefinitions(IRNode* head) {
+    ops.clear();
+    int maxVR = -1;
+    for (IRNode* node = head; node; node = node->next) {
+        ops.push_back(node);
+        maxVR = std::max({maxVR, node->vr1, node->vr2, node->vr3});
+    }
+
+    // live-in values and definitions, plus one VR per op a rebuild may add
+    size_t capacity = (size_t)(maxVR + 1) + 2 * ops.size();
+    defOp.assign(capacity, -1);
+    uses.assign(capacity, 0);
+    userOp.assign(capacity, -1);
+    ready.assign(capacity, 0);
+    nextVR = 0;
+    rebuilt = 0;
+
+    std::vector<int> current(maxVR + 1, -1); // old VR -> VR of its live value
+    int index = 0;
+    auto use = [&](int& vr) {
+        if (vr < 0) return;
+        if (current[vr] < 0) current[vr] = nextVR++;  // live-in
+        vr = current[vr];
+        uses[vr]++;
+        userOp[vr] = index;
+    };
+    auto def = [&](int& vr) {
+        if (vr < 0) return;
+        current[vr] = nextVR++;
+        vr = current[vr];
+        defOp[vr] = index;
+    };
+
+    for (index = 0; index < (int)ops.size(); index++) {
+        IRNode* node = ops[index];
+        switch (node->opcode) {
+            case TOKEN_LOAD:
+                use(node->vr1);
+                def(node->vr3);
+                break;
+            case TOKEN_LOADI:
+                def(node->vr3);
+                break;
+            case TOKEN_STORE:
+                use(node->vr1);
+                use(node->vr3);
+                break;
+            case TOKEN_ADD:
+            case TOKEN_SUB:
+            case TOKEN_MULT:
+            case TOKEN_LSHIFT:
+            case TOKEN_RSHIFT:
+                use(node->vr1);
+                use(node->vr2);
+                def(node->vr3);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// vr is defined by an `opcode` op and read once, by another `opcode` op:
+// it is an inner node of a larger tree rather than a value of its own
+bool TreeHeightReducer::isInterior(int vr, TokenType opcode) const {
+    int d = defOp[vr];
+    if (d < 0 || uses[vr] != 1 || !ops[d] || ops[d]->opcode != opcode)
+        return false;
+    const IRNode* user = ops[userOp[vr]];
+    return user && user->opcode == opcode;
+}
+
+// walk the tree under ops[root]; inner ops go to `absorbed`, the values
+// they combine to `leaves`. An explicit stack keeps long chains off the
+// call stack
+void TreeHeightReducer::collectLeaves(int root, std::vector<Leaf>& leaves,
+                                      std::vector<int>& absorbed) const {
+    TokenType opcode = ops[root]->opcode;
+    std::vector<int> stack = {ops[root]->vr2, ops[root]->vr1};
+    while (!stack.empty()) {
+        int vr = stack.back();
+        stack.pop_back();
+        if (isInterior(vr, opcode)) {
+            int d = defOp[vr];
+            absorbed.push_back(d);
+            stack.push_back(ops[d]->vr2);
+            stack.push_back(ops[d]->vr1);
+        } else {
+            leaves.push_back({vr, ready[vr]});
+        }
+    }
+}
+
+// combine the two earliest-ready values until one is left (the Huffman
+// construction, which gives the lowest tree for the given ready cycles);
+// the rebuilt ops replace the absorbed ones and the last reuses ops[root]
+IRNode* TreeHeightReducer::rebuild(int root, std::vector<Leaf>& leaves,
+                                   const std::vector<int>& absorbed, IRNode* head) {
+    IRNode* rootNode = ops[root];
+    int latency = latencyOf(rootNode->opcode);
+
+    auto later = [](const Leaf& a, const Leaf& b) {
+        return a.ready != b.ready ? a.ready > b.ready : a.vr > b.vr;
+    };
+    std::priority_queue<Leaf, std::vector<Leaf>, decltype(later)> pending(later, leaves);
+
+    // drop the absorbed ops; their results were read only inside the tree
+    for (int d : absorbed) {
+        IRNode* node = ops[d];
+        if (node->prev) node->prev->next = node->next;
+        else head = node->next;
+        if (node->next) node->next->prev = node->prev;
+        ops[d] = nullptr;
+        delete node;
+    }
+
+    while (pending.size() > 2) {
+        Leaf a = pending.top(); pending.pop();
+        Leaf b = pending.top(); pending.pop();
+
+        IRNode* node = new IRNode();
+        node->line = rootNode->line;
+        node->opcode = rootNode->opcode;
+        node->vr1 = a.vr;
+        node->vr2 = b.vr;
+        node->vr3 = nextVR++;
+
+        node->prev = rootNode->prev;
+        node->next = rootNode;
+        if (rootNode->prev) rootNode->prev->next = node;
+        else head = node;
+        rootNode->prev = node;
+
+        ready[node->vr3] = std::max(a.ready, b.ready) + latency;
+        pending.push({node->vr3, ready[node->vr3]});
+    }
+
+    Leaf a = pending.top(); pending.pop();
+    Leaf b = pending.top(); pending.pop();
+    rootNode->vr1 = a.vr;
+    rootNode->vr2 = b.vr;
+    ready[rootNode->vr3] = std::max(a.ready, b.ready) + latency;
+    rebuilt++;
+    return head;
+}
+
+IRNode* TreeHeightReducer::reduce(IRNode* head) {
+    if (!head) return head;
+    renameDefinitions(head);
+
+    std::vector<Leaf> leaves;
+    std::vector<int> absorbed;
+    for (int i = 0; i < (int)ops.size(); i++) {
+        IRNode* node = ops[i];
+        if (!node) continue;  // absorbed into a later tree
+
+        switch (node->opcode) {
+            case TOKEN_LOADI:
+                ready[node->vr3] = 1;
+                break;
+            case TOKEN_LOAD:
+                ready[node->vr3] = ready[node->vr1] + latencyOf(TOKEN_LOAD);
+                break;
+            case TOKEN_ADD:
+            case TOKEN_SUB:
+            case TOKEN_MULT:
+            case TOKEN_LSHIFT:
+            case TOKEN_RSHIFT: {
+                int height = std::max(ready[node->vr1], ready[node->vr2]) + latencyOf(node->opcode);
+                ready[node->vr3] = height;
+
+                bool associative = node->opcode == TOKEN_ADD || node->opcode == TOKEN_MULT;
+                if (!associative || isInterior(node->vr3, node->opcode))
+                    break;
+
+                leaves.clear();
+                absorbed.clear();
+                collectLeaves(i, leaves, absorbed);
+                if (absorbed.empty())
+                    break;
+
+                // rebuild only when the tree gets lower
+                std::priority_queue<int, std::vector<int>, std::greater<int>> cycles;
+                for (const Leaf& leaf : leaves) cycles.push(leaf.ready);
+                while (cycles.size() > 1) {
+                    int a = cycles.top(); cycles.pop();
+                    int b = cycles.top(); cycles.pop();
+                    cycles.push(std::max(a, b) + latencyOf(node->opcode));
+                }
+                if (cycles.top() < height)
+                    head = rebuild(i, leaves, absorbed, head);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return head;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "parser.h"
+#include <vector>
+
+// Tree-height reduction. A chain like
+//     add r1, r2 => r3; add r3, r4 => r5; add r5, r6 => r7
+// is three dependent adds; rebuilt as a tree it is two levels deep, and the
+// two adds of the first level can issue in the same cycle. add and mult are
+// associative and commutative in 32-bit wraparound arithmetic, so any
+// order gives the same result.
+class TreeHeightReducer {
+public:
+    TreeHeightReducer();
+
+    // rewrite the renamed block in place and return its (possibly new) head.
+    // Every definition gets its own VR first, so a value stays available
+    // for as long as the rebuilt tree needs it
+    IRNode* reduce(IRNode* head);
+
+    int treesRebuilt() const { return rebuilt; }   // by the last reduce()
+
+private:
+    // an operand of a rebuilt tree, ordered by the cycle it is expected to be ready
+    struct Leaf {
+        int vr;
+        int ready;
+    };
+
+    std::vector<IRNode*> ops;   // the block, in order
+    std::vector<int> defOp;     // VR -> index of the op defining it (-1 = live-in)
+    std::vector<int> uses;      // VR -> number of reads
+    std::vector<int> userOp;    // VR -> index of the last op reading it
+    std::vector<int> ready;     // VR -> estimated cycle its value is ready
+    int nextVR;
+    int rebuilt;
+
+    void renameDefinitions(IRNode* head);
+    bool isInterior(int vr, TokenType opcode) const; // single-use result of the same op
+    void collectLeaves(int root, std::vector<Leaf>& leaves, std::vector<int>& absorbed) const;
+    IRNode* rebuild(int root, std::vector<Leaf>& leaves, const std::vector<int>& absorbed, IRNode* head);
+
+    static int latencyOf(TokenType opcode);
+};
@@ -77,74 +77,74 @@ void RegisterRenamer::rename(IRNode* head) {
 }
 
 //helper for printing
-void RegisterRenamer::printInstruction(IRNode* node) {
+void RegisterRenamer::printInstruction(IRNode* node, std::ostream& out) {
     switch (node->opcode) {
 
         case TOKEN_LOAD:
-            std::cout << "load r" << node->vr1
-                      << " => r" << node->vr3;
+            out << "load r" << node->vr1
+                << " => r" << node->vr3;
             break;
 
         case TOKEN_LOADI:
-            std::cout << "loadI " << node->sr1
-                      << " => r" << node->vr3;
+            out << "loadI " << node->sr1
+                << " => r" << node->vr3;
             break;
 
         case TOKEN_STORE:
-            std::cout << "store r" << node->vr1
-                      << " => r" << node->vr3;
+            out << "store r" << node->vr1
+                << " => r" << node->vr3;
             break;
 
         case TOKEN_ADD:
-            std::cout << "add r" << node->vr1
-                      << ", r" << node->vr2
-                      << " => r" << node->vr3;
+            out << "add r" << node->vr1
+                << ", r" << node->vr2
+                << " => r" << node->vr3;
             break;
 
         case TOKEN_SUB:
-            std::cout << "sub r" << node->vr1
-                      << ", r" << node->vr2
-                      << " => r" << node->vr3;
+            out << "sub r" << node->vr1
+                << ", r" << node->vr2
+                << " => r" << node->vr3;
             break;
 
         case TOKEN_MULT:
-            std::cout << "mult r" << node->vr1
-                      << ", r" << node->vr2
-                      << " => r" << node->vr3;
+            out << "mult r" << node->vr1
+                << ", r" << node->vr2
+                << " => r" << node->vr3;
             break;
 
         case TOKEN_LSHIFT:
-            std::cout << "lshift r" << node->vr1
-                      << ", r" << node->vr2
-                      << " => r" << node->vr3;
+            out << "lshift r" << node->vr1
+                << ", r" << node->vr2
+                << " => r" << node->vr3;
             break;
 
         case TOKEN_RSHIFT:
-            std::cout << "rshift r" << node->vr1
-                      << ", r" << node->vr2
-                      << " => r" << node->vr3;
+            out << "rshift r" << node->vr1
+                << ", r" << node->vr2
+                << " => r" << node->vr3;
             break;
 
         case TOKEN_OUTPUT:
-            std::cout << "output " << node->sr1;
+            out << "output " << node->sr1;
             break;
 
         case TOKEN_NOP:
-            std::cout << "nop";
+            out << "nop";
             break;
 
         default:
             break;
     }
 
-    std::cout << std::endl;
+    out << '\n';
 }
 
 //print IR for -x flag
-void RegisterRenamer::printRenamedIR(IRNode* head) {
+void RegisterRenamer::printRenamedIR(IRNode* head, std::ostream& out) {
     IRNode* current = head;
     while (current != nullptr) {
-        printInstruction(current);
+        printInstruction(current, out);
         current = current->next;
     }
 }
\ No newline at end of file
@@ -1,9 +1,12 @@
 #include "scanner.h"
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <unordered_map>
 
-//map to identify opcode
-std::unordered_map<std::string, TokenType> opcodeMap = {
+//map to identify opcode; const and local to this file, so scanners on
+//different threads only ever read it
+static const std::unordered_map<std::string, TokenType> opcodeMap = {
     {"load", TOKEN_LOAD},
     {"loadI", TOKEN_LOADI},
     {"store", TOKEN_STORE},
@@ -18,7 +21,7 @@ std::unordered_map<std::string, TokenType> opcodeMap = {
 
 //constructor
 Scanner::Scanner(const std::string& filename) 
-    : curr_size(0), pos(0), line(1) {
+    : memory(nullptr), memorySize(0), memoryPos(0), curr_size(0), pos(0), line(1) {
     
     input.open(filename);
     if (!input.is_open()) {
@@ -31,7 +34,21 @@ Scanner::Scanner(const std::string& filename)
 }
 
 
+Scanner::Scanner(const char* data, size_t size)
+    : memory(data), memorySize(size), memoryPos(0), curr_size(0), pos(0), line(1) {
+    fillBuffer();
+}
+
+
 bool Scanner::fillBuffer() {
+    if (memory) {
+        curr_size = std::min(BUFSIZE, memorySize - memoryPos);
+        std::memcpy(buffer, memory + memoryPos, curr_size);
+        memoryPos += curr_size;
+        pos = 0;
+        return curr_size > 0;
+    }
+
     //check if input is good
     if (!input.good()) {
         curr_size = 0;
@@ -152,8 +169,9 @@ Token Scanner::nextToken() {
         }
 
         // check opcode map
-        if (opcodeMap.count(lex)) {
-            return {opcodeMap[lex], line, lex};
+        auto opcode = opcodeMap.find(lex);
+        if (opcode != opcodeMap.end()) {
+            return {opcode->second, line, lex};
         }
 
         return {TOKEN_ERROR, line, lex};
@@ -43,6 +43,9 @@ private:
     static constexpr size_t BUFSIZE = 16 * 1024; //buffer size (using 16kb buffer b/c 120,000 lines)
 
     std::ifstream input;   // file input stream
+    const char* memory;    // in-memory input instead of the file, or nullptr
+    size_t memorySize;
+    size_t memoryPos;
     char buffer[BUFSIZE];   //input buffer
 
     size_t curr_size;   //num char is current buffer
@@ -63,6 +66,9 @@ public:
     //explicit constructor to prevent type conversions
     explicit Scanner(const std::string& filename);
 
+    // scan `size` bytes at `data`, which must outlive the scanner
+    Scanner(const char* data, size_t size);
+
     Token nextToken();
     void scanAll();  //for -s flag
 };
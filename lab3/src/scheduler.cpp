@@ -1,14 +1,28 @@
 #include "scheduler.h"
 #include "renamer.h"
 #include <algorithm>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <random>
+#include <thread>
+#include <climits>
 
 // ---------------------------------------------------------------------------
 // SchedulerNode
 // ---------------------------------------------------------------------------
 
-SchedulerNode::SchedulerNode(IRNode* node, int node_id)
-    : ir(node), id(node_id), priority(0), in_degree(0), ready_at_cycle(1) {
+SchedulerNode::SchedulerNode(IRNode* node, int node_id) {
+    reset(node, node_id);
+}
+
+void SchedulerNode::reset(IRNode* node, int node_id) {
+    ir = node;
+    id = node_id;
+    priority = depth = descendants = ancestors = 0;
+    earliest = slack = in_degree = 0;
+    children.clear();
+    parents.clear();
 
     switch (node->opcode) {
         case TOKEN_LOAD:
@@ -44,18 +58,28 @@ void DependencyGraph::build(IRNode* head) {
     int count = 0;
     IRNode* curr = head;
 
-    // last writer per VR (for RAW / WAW)
-    std::map<int, SchedulerNode*> last_def;
-    // all live readers per VR (for WAR)
-    std::map<int, std::vector<SchedulerNode*>> last_uses;
-
-    // Memory ordering: single-predecessor chain (O(n) edges, not O(n^2))
+    // the def and use tables are indexed by VR
+    int maxVR = -1;
+    for (IRNode* node = head; node; node = node->next)
+        maxVR = std::max({maxVR, node->vr1, node->vr2, node->vr3});
+    lastDef.assign(maxVR + 1, nullptr);
+    if (lastUses.size() < lastDef.size()) lastUses.resize(lastDef.size());
+    for (int reg = 0; reg <= maxVR; reg++) lastUses[reg].clear();
+    nodes.clear();
+
+    // Memory ordering: single-predecessor chain (O(n) edges, not O(n^2)).
+    // Loads are not chained to each other, so every load since the last
+    // store needs its own WAR edge to the next store.
     SchedulerNode* last_store  = nullptr;
-    SchedulerNode* last_load   = nullptr;
+    loadsSinceStore.clear();
     SchedulerNode* last_output = nullptr;
 
     while (curr) {
-        SchedulerNode* node = new SchedulerNode(curr, count++);
+        if ((size_t)count == pool.size())
+            pool.push_back(std::make_unique<SchedulerNode>(curr, count));
+        else
+            pool[count]->reset(curr, count);
+        SchedulerNode* node = pool[count++].get();
         nodes.push_back(node);
 
         // Process all USE operands first, then DEF.
@@ -66,19 +90,19 @@ void DependencyGraph::build(IRNode* head) {
 
         auto record_use = [&](int reg) {
             if (reg == -1) return;
-            if (last_def.count(reg))
-                addEdge(last_def[reg], node);           // RAW
-            last_uses[reg].push_back(node);
+            if (lastDef[reg])
+                addEdge(lastDef[reg], node);            // RAW
+            lastUses[reg].push_back(node);
         };
 
         auto record_def = [&](int reg) {
             if (reg == -1) return;
-            if (last_def.count(reg))
-                addEdge(last_def[reg], node);           // WAW
-            for (auto* use : last_uses[reg])
+            if (lastDef[reg])
+                addEdge(lastDef[reg], node);            // WAW
+            for (auto* use : lastUses[reg])
                 addEdge(use, node);                     // WAR
-            last_uses[reg].clear();
-            last_def[reg] = node;
+            lastUses[reg].clear();
+            lastDef[reg] = node;
         };
 
         switch (curr->opcode) {
@@ -112,12 +136,14 @@ void DependencyGraph::build(IRNode* head) {
         // Memory/output ordering (conservative aliasing assumed)
         if (curr->opcode == TOKEN_STORE) {
             if (last_store)  addEdge(last_store,  node); // store->store WAW
-            if (last_load)   addEdge(last_load,   node); // load->store  WAR
+            for (auto* load : loadsSinceStore)
+                addEdge(load, node);                     // load->store  WAR
             if (last_output) addEdge(last_output, node); // output->store WAR
             last_store = node;
+            loadsSinceStore.clear();
         } else if (curr->opcode == TOKEN_LOAD) {
             if (last_store)  addEdge(last_store,  node); // store->load RAW
-            last_load = node;
+            loadsSinceStore.push_back(node);
         } else if (curr->opcode == TOKEN_OUTPUT) {
             if (last_store)  addEdge(last_store,  node); // store->output RAW
             if (last_output) addEdge(last_output, node); // preserve print order
@@ -164,6 +190,118 @@ void DependencyGraph::computePriorities() {
     }
 }
 
+// ---------------------------------------------------------------------------
+// computeTieBreakers — depth from the roots plus descendant / ancestor
+// estimates. The estimates sum over paths, so shared subgraphs are counted
+// more than once; they only order ops with equal path length.
+// ---------------------------------------------------------------------------
+void DependencyGraph::computeTieBreakers() {
+    int n = nodes.size();
+
+    // topological order (Kahn's algorithm on the graph itself)
+    std::vector<int> remaining(n, 0);
+    std::vector<SchedulerNode*> order;
+    order.reserve(n);
+    for (auto* node : nodes) {
+        remaining[node->id] = (int)node->parents.size();
+        if (node->parents.empty())
+            order.push_back(node);
+    }
+    for (size_t head = 0; head < order.size(); head++) {
+        for (auto* child : order[head]->children) {
+            remaining[child->id]--;
+            if (remaining[child->id] == 0)
+                order.push_back(child);
+        }
+    }
+
+    auto saturatingAdd = [](int a, int b) {
+        return (a > INT_MAX - b) ? INT_MAX : a + b;
+    };
+
+    for (auto* node : order) {
+        node->depth = node->latency;
+        node->ancestors = 0;
+        for (auto* parent : node->parents) {
+            node->depth = std::max(node->depth, parent->depth + node->latency);
+            node->ancestors = saturatingAdd(node->ancestors, saturatingAdd(parent->ancestors, 1));
+        }
+    }
+
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        SchedulerNode* node = *it;
+        node->descendants = 0;
+        for (auto* child : node->children)
+            node->descendants = saturatingAdd(node->descendants, saturatingAdd(child->descendants, 1));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// computeSlack — ASAP issue cycle from the roots, longest issue-to-issue
+// distance to a sink, and the slack between them. The critical path is the
+// last cycle any sink can issue in, a lower bound on the schedule length.
+// ---------------------------------------------------------------------------
+int DependencyGraph::computeSlack() {
+    int n = nodes.size();
+
+    std::vector<int> remaining(n, 0);
+    std::vector<SchedulerNode*> order;
+    order.reserve(n);
+    for (auto* node : nodes) {
+        remaining[node->id] = (int)node->parents.size();
+        if (node->parents.empty())
+            order.push_back(node);
+    }
+    for (size_t head = 0; head < order.size(); head++) {
+        for (auto* child : order[head]->children) {
+            remaining[child->id]--;
+            if (remaining[child->id] == 0)
+                order.push_back(child);
+        }
+    }
+
+    int criticalPath = 0;
+    for (auto* node : order) {
+        node->earliest = 1;
+        for (auto* parent : node->parents)
+            node->earliest = std::max(node->earliest, parent->earliest + parent->latency);
+        criticalPath = std::max(criticalPath, node->earliest);
+    }
+
+    // tail[id] = cycles between this op's issue and the last sink's issue
+    std::vector<int> tail(n, 0);
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        SchedulerNode* node = *it;
+        for (auto* child : node->children)
+            tail[node->id] = std::max(tail[node->id], node->latency + tail[child->id]);
+        node->slack = criticalPath - tail[node->id] - node->earliest;
+    }
+    return criticalPath;
+}
+
+// DOT dump; ops and edges on a critical path are drawn in red
+void DependencyGraph::writeDot(std::ostream& out) const {
+    out << "digraph dependences {\n";
+    out << "  node [shape=box, fontname=\"monospace\"];\n";
+    for (auto* node : nodes) {
+        out << "  n" << node->id << " [label=\"" << node->id << ": ";
+        printOp(out, node->ir);
+        out << "\\nprio " << node->priority << ", slack " << node->slack << "\"";
+        if (node->slack == 0) out << ", color=red";
+        out << "];\n";
+    }
+    for (auto* node : nodes) {
+        for (auto* child : node->children) {
+            out << "  n" << node->id << " -> n" << child->id << " [label=\"" << node->latency << "\"";
+            if (node->slack == 0 && child->slack == 0 &&
+                child->earliest == node->earliest + node->latency)
+                out << ", color=red";
+            out << "];\n";
+        }
+    }
+    out << "}\n";
+}
+
 // ---------------------------------------------------------------------------
 // Scheduler
 // ---------------------------------------------------------------------------
@@ -179,111 +317,510 @@ bool Scheduler::canFit(IRNode* ir, int unit) {
     }
 }
 
-static void printOp(IRNode* node) {
+void printOp(std::ostream& out, const IRNode* node) {
     if (!node || node->opcode == TOKEN_NOP) {
-        std::cout << "nop";
+        out << "nop";
         return;
     }
     switch (node->opcode) {
         case TOKEN_LOAD:
-            std::cout << "load r"   << node->vr1 << " => r" << node->vr3; break;
+            out << "load r"   << node->vr1 << " => r" << node->vr3; break;
         case TOKEN_LOADI:
-            std::cout << "loadI "   << node->sr1 << " => r" << node->vr3; break;
+            out << "loadI "   << node->sr1 << " => r" << node->vr3; break;
         case TOKEN_STORE:
-            std::cout << "store r"  << node->vr1 << " => r" << node->vr3; break;
+            out << "store r"  << node->vr1 << " => r" << node->vr3; break;
         case TOKEN_ADD:
-            std::cout << "add r"    << node->vr1 << ", r" << node->vr2 << " => r" << node->vr3; break;
+            out << "add r"    << node->vr1 << ", r" << node->vr2 << " => r" << node->vr3; break;
         case TOKEN_SUB:
-            std::cout << "sub r"    << node->vr1 << ", r" << node->vr2 << " => r" << node->vr3; break;
+            out << "sub r"    << node->vr1 << ", r" << node->vr2 << " => r" << node->vr3; break;
         case TOKEN_MULT:
-            std::cout << "mult r"   << node->vr1 << ", r" << node->vr2 << " => r" << node->vr3; break;
+            out << "mult r"   << node->vr1 << ", r" << node->vr2 << " => r" << node->vr3; break;
         case TOKEN_LSHIFT:
-            std::cout << "lshift r" << node->vr1 << ", r" << node->vr2 << " => r" << node->vr3; break;
+            out << "lshift r" << node->vr1 << ", r" << node->vr2 << " => r" << node->vr3; break;
         case TOKEN_RSHIFT:
-            std::cout << "rshift r" << node->vr1 << ", r" << node->vr2 << " => r" << node->vr3; break;
+            out << "rshift r" << node->vr1 << ", r" << node->vr2 << " => r" << node->vr3; break;
         case TOKEN_OUTPUT:
-            std::cout << "output "  << node->sr1; break;
+            out << "output "  << node->sr1; break;
+        default:
+            out << "nop"; break;
+    }
+}
+
+std::vector<int> Scheduler::rankNodes(ScheduleDirection dir, TieBreaker tie) const {
+    bool forward = (dir == SCHEDULE_FORWARD);
+
+    auto pathLength = [forward](const SchedulerNode* n) {
+        return forward ? n->priority : n->depth;
+    };
+    auto tieKey = [forward, tie](const SchedulerNode* n) -> long long {
+        switch (tie) {
+            case TIE_DESCENDANTS:
+                return forward ? n->descendants : n->ancestors;
+            case TIE_FANOUT:
+                return forward ? (long long)n->children.size() : (long long)n->parents.size();
+            default:
+                return 0;
+        }
+    };
+
+    std::vector<SchedulerNode*> order(graph.nodes);
+    std::sort(order.begin(), order.end(),
+              [&](const SchedulerNode* a, const SchedulerNode* b) {
+        if (pathLength(a) != pathLength(b))
+            return pathLength(a) > pathLength(b);
+        if (tieKey(a) != tieKey(b))
+            return tieKey(a) > tieKey(b);
+        // final tie breaker: program order, read from the end when going backward
+        return forward ? a->id < b->id : a->id > b->id;
+    });
+
+    int n = order.size();
+    std::vector<int> rank(n);
+    for (int i = 0; i < n; i++)
+        rank[order[i]->id] = n - i;
+    return rank;
+}
+
+// registers an op reads and writes (renamed VRs, -1 when absent)
+static void operandsOf(const IRNode* ir, int& use1, int& use2, int& def) {
+    use1 = use2 = def = -1;
+    switch (ir->opcode) {
+        case TOKEN_LOAD:
+            use1 = ir->vr1;
+            def = ir->vr3;
+            break;
+        case TOKEN_LOADI:
+            def = ir->vr3;
+            break;
+        case TOKEN_STORE:
+            use1 = ir->vr1;
+            use2 = ir->vr3;
+            break;
+        case TOKEN_ADD:
+        case TOKEN_SUB:
+        case TOKEN_MULT:
+        case TOKEN_LSHIFT:
+        case TOKEN_RSHIFT:
+            use1 = ir->vr1;
+            use2 = ir->vr2;
+            def = ir->vr3;
+            break;
         default:
-            std::cout << "nop"; break;
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// RegisterPressure — live value count during a forward list schedule. The
+// renamer gives a source register one VR for the whole block, so liveness is
+// tracked per definition: a value is live from the op that defines it (or
+// block entry, for a VR read before any definition) until the last of its
+// readers issues. The WAR edges keep every reader of a value ahead of the
+// next definition of its VR, so the readers are all a value needs.
+// ---------------------------------------------------------------------------
+namespace {
+
+class RegisterPressure {
+public:
+    explicit RegisterPressure(const std::vector<SchedulerNode*>& nodes) : current(0) {
+        int max_vr = -1;
+        for (auto* node : nodes) {
+            int u1, u2, d;
+            operandsOf(node->ir, u1, u2, d);
+            max_vr = std::max({max_vr, u1, u2, d});
+        }
+
+        // value ids: a node's id for the value it defines, nodes.size() + vr
+        // for the value a VR holds on entry. nodes are in program order, so
+        // the value a use reads is the one its VR was last defined to
+        int total = (int)nodes.size();
+        std::vector<int> current_value(max_vr + 1, -1);
+        for (int vr = 0; vr <= max_vr; vr++) current_value[vr] = total + vr;
+        operands.assign(total, {-1, -1, -1});
+        readers.assign(total + max_vr + 1, 0);
+        live.assign(total + max_vr + 1, 0);
+
+        for (auto* node : nodes) {
+            int u1, u2, d;
+            operandsOf(node->ir, u1, u2, d);
+            std::array<int, 3>& values = operands[node->id];
+            if (u1 >= 0) values[0] = current_value[u1];
+            if (u2 >= 0 && u2 != u1) values[1] = current_value[u2];
+            for (int i = 0; i < 2; i++) {
+                if (values[i] >= 0) readers[values[i]]++;
+            }
+            if (d >= 0) {
+                values[2] = node->id;
+                current_value[d] = node->id;
+            }
+        }
+        for (int vr = 0; vr <= max_vr; vr++) {
+            live[total + vr] = readers[total + vr] > 0;
+            current += live[total + vr];
+        }
     }
+
+    int pressure() const { return current; }
+
+    // change in live values if this op issued now
+    int delta(const SchedulerNode* node) const {
+        const std::array<int, 3>& values = operands[node->id];
+        int change = 0;
+        for (int i = 0; i < 2; i++) {
+            if (values[i] >= 0 && live[values[i]] && readers[values[i]] == 1) change--;
+        }
+        if (values[2] >= 0 && readers[values[2]] > 0) change++;
+        return change;
+    }
+
+    void issue(const SchedulerNode* node) {
+        current += delta(node);
+        const std::array<int, 3>& values = operands[node->id];
+        for (int i = 0; i < 2; i++) {
+            if (values[i] >= 0 && --readers[values[i]] == 0) live[values[i]] = 0;
+        }
+        if (values[2] >= 0) live[values[2]] = readers[values[2]] > 0;
+    }
+
+private:
+    std::vector<std::array<int, 3>> operands;  // per node: values read, value defined
+    std::vector<int> readers;                  // per value: readers not yet issued
+    std::vector<char> live;
+    int current;
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// listSchedule — forward: an op is ready once every parent has completed
+// (issue + parent latency). Backward: cycles count from the end of the block,
+// so a parent may only be placed lat(parent) cycles before its last child;
+// the finished cycle list is reversed.
+// ---------------------------------------------------------------------------
+Schedule Scheduler::listSchedule(ScheduleDirection dir, const std::vector<int>& rank,
+                                 int pressureLimit) const {
+    Schedule sched;
+    ListBuffers buffers;
+    listScheduleInto(sched, dir, rank, pressureLimit, buffers, Clock::time_point::max());
+    return sched;
 }
 
-void Scheduler::schedule() {
-    std::priority_queue<SchedulerNode*,
-                        std::vector<SchedulerNode*>,
-                        ComparePriority> ready_q;
-    std::vector<SchedulerNode*> active;
+bool Scheduler::listScheduleInto(Schedule& sched, ScheduleDirection dir, const std::vector<int>& rank,
+                                 int pressureLimit, ListBuffers& buffers,
+                                 Clock::time_point deadline) const {
+    bool forward = (dir == SCHEDULE_FORWARD);
+    int total_nodes = (int)graph.nodes.size();
 
+    bool track_pressure = forward && pressureLimit > 0;
+    RegisterPressure pressure(track_pressure ? graph.nodes : std::vector<SchedulerNode*>());
+    std::vector<std::pair<int, int>>& candidates = buffers.candidates;
+
+    // ready ops, a heap with the highest rank on top
+    std::vector<int>& ready_q = buffers.ready;
+    auto higherRank = [&rank](int a, int b) { return rank[a] < rank[b]; };
+    auto pushReady = [&](int id) {
+        ready_q.push_back(id);
+        std::push_heap(ready_q.begin(), ready_q.end(), higherRank);
+    };
+    auto popReady = [&]() {
+        std::pop_heap(ready_q.begin(), ready_q.end(), higherRank);
+        ready_q.pop_back();
+    };
+
+    // ops whose predecessors are all placed, keyed by the cycle their operands
+    // are ready; a heap with the earliest on top
+    std::vector<std::pair<int, int>>& pending = buffers.pending;   // (cycle, id)
+    std::greater<std::pair<int, int>> later;
+
+    std::vector<int>& remaining = buffers.remaining;
+    std::vector<int>& earliest = buffers.earliest;
+    std::vector<int>& deferred = buffers.deferred;
+    ready_q.clear();
+    pending.clear();
+    remaining.resize(total_nodes);
+    earliest.assign(total_nodes, 1);
     for (auto* node : graph.nodes) {
-        if (node->in_degree == 0)
-            ready_q.push(node);
+        remaining[node->id] = forward ? (int)node->parents.size() : (int)node->children.size();
+        if (remaining[node->id] == 0)
+            pushReady(node->id);
     }
 
+    sched.clear();
     int cycle = 1;
     int scheduled_count = 0;
-    int total_nodes = (int)graph.nodes.size();
 
     while (scheduled_count < total_nodes) {
-
-        // 1. Retire completed ops and release their dependents
-        auto it = active.begin();
-        while (it != active.end()) {
-            if (cycle >= (*it)->ready_at_cycle) {
-                for (auto* child : (*it)->children) {
-                    child->in_degree--;
-                    if (child->in_degree == 0)
-                        ready_q.push(child);
-                }
-                it = active.erase(it);
-            } else {
-                ++it;
-            }
+        // a clock read every 256 cycles keeps a deadline cheap to honour
+        if ((cycle & 255) == 0 && deadline != Clock::time_point::max() && Clock::now() >= deadline)
+            return false;
+
+        // 1. Release ops whose operands are available this cycle
+        while (!pending.empty() && pending.front().first <= cycle) {
+            pushReady(pending.front().second);
+            std::pop_heap(pending.begin(), pending.end(), later);
+            pending.pop_back();
         }
 
         // 2. Issue: fill f0 then f1
-        SchedulerNode* op0 = nullptr;
-        SchedulerNode* op1 = nullptr;
+        Bundle bundle = {nullptr, nullptr};
         bool output_issued = false;
+        deferred.clear();
+
+        // Near the pressure limit, take the best-ranked ready ops and try the
+        // ones that free registers first; otherwise issue straight off the
+        // ready queue. The window keeps a huge ready set from going quadratic.
+        const size_t PRESSURE_WINDOW = 128;
+        bool reorder = track_pressure && pressure.pressure() + 1 >= pressureLimit;
+        bool at_limit = track_pressure && pressure.pressure() >= pressureLimit;
+        candidates.clear();
+        if (reorder) {
+            while (!ready_q.empty() && candidates.size() < PRESSURE_WINDOW) {
+                int id = ready_q.front();
+                candidates.push_back({pressure.delta(graph.nodes[id]), id});
+                popReady();
+            }
+            // candidates come out in rank order, so a stable sort keeps it as the tie breaker
+            std::stable_sort(candidates.begin(), candidates.end(),
+                             [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+                return a.first < b.first;
+            });
+        }
+        size_t next_candidate = 0;
 
-        std::vector<SchedulerNode*> deferred;
-
-        while (!ready_q.empty() && (!op0 || !op1)) {
-            SchedulerNode* node = ready_q.top();
-            ready_q.pop();
+        while (!bundle[0] || !bundle[1]) {
+            int id;
+            if (reorder) {
+                if (next_candidate == candidates.size()) break;
+                id = candidates[next_candidate++].second;
+            } else {
+                if (ready_q.empty()) break;
+                id = ready_q.front();
+                popReady();
+            }
+            SchedulerNode* node = graph.nodes[id];
 
             if (node->ir->opcode == TOKEN_OUTPUT && output_issued) {
-                deferred.push_back(node);
+                deferred.push_back(node->id);
                 continue;
             }
 
-            bool issued = false;
-            if (!op0 && canFit(node->ir, 0)) {
-                op0 = node;
-                issued = true;
-            } else if (!op1 && canFit(node->ir, 1)) {
-                op1 = node;
-                issued = true;
+            // At the limit an op that adds a live VR waits, unless the cycle
+            // would otherwise stay empty with nothing in flight to free one.
+            if (at_limit && pressure.delta(node) > 0
+                && (bundle[0] || bundle[1] || !pending.empty())) {
+                deferred.push_back(node->id);
+                continue;
             }
 
-            if (issued) {
-                if (node->ir->opcode == TOKEN_OUTPUT) output_issued = true;
-                node->ready_at_cycle = cycle + node->latency;
-                active.push_back(node);
-                scheduled_count++;
-            } else {
-                deferred.push_back(node);
+            int unit = -1;
+            if (!bundle[0] && canFit(node->ir, 0)) {
+                unit = 0;
+            } else if (!bundle[1] && canFit(node->ir, 1)) {
+                unit = 1;
             }
-        }
 
-        for (auto* d : deferred) ready_q.push(d);
+            if (unit < 0) {
+                deferred.push_back(node->id);
+                continue;
+            }
 
-        // 3. Print the cycle
-        std::cout << "[ ";
-        printOp(op0 ? op0->ir : nullptr);
-        std::cout << " ; ";
-        printOp(op1 ? op1->ir : nullptr);
-        std::cout << " ]" << std::endl;
+            bundle[unit] = node;
+            if (node->ir->opcode == TOKEN_OUTPUT) output_issued = true;
+            scheduled_count++;
+            if (track_pressure) pressure.issue(node);
+
+            const auto& successors = forward ? node->children : node->parents;
+            for (auto* succ : successors) {
+                int delay = forward ? node->latency : succ->latency;
+                earliest[succ->id] = std::max(earliest[succ->id], cycle + delay);
+                remaining[succ->id]--;
+                if (remaining[succ->id] == 0) {
+                    pending.push_back({earliest[succ->id], succ->id});
+                    std::push_heap(pending.begin(), pending.end(), later);
+                }
+            }
+        }
+
+        for (int d : deferred) pushReady(d);
+        for (size_t i = next_candidate; i < candidates.size(); i++) pushReady(candidates[i].second);
 
+        sched.push_back(bundle);
         cycle++;
     }
-}
\ No newline at end of file
+
+    if (!forward)
+        std::reverse(sched.begin(), sched.end());
+    return true;
+}
+
+Schedule Scheduler::schedule() const {
+    return listSchedule(SCHEDULE_FORWARD, rankNodes(SCHEDULE_FORWARD, TIE_ID));
+}
+
+Schedule Scheduler::schedulePressure(int pressureLimit) const {
+    return listSchedule(SCHEDULE_FORWARD, rankNodes(SCHEDULE_FORWARD, TIE_ID), pressureLimit);
+}
+
+Schedule Scheduler::scheduleBest() const {
+    struct Config {
+        ScheduleDirection dir;
+        TieBreaker tie;
+    };
+    static const Config configs[] = {
+        {SCHEDULE_FORWARD,  TIE_ID},
+        {SCHEDULE_FORWARD,  TIE_DESCENDANTS},
+        {SCHEDULE_FORWARD,  TIE_FANOUT},
+        {SCHEDULE_BACKWARD, TIE_ID},
+        {SCHEDULE_BACKWARD, TIE_DESCENDANTS},
+        {SCHEDULE_BACKWARD, TIE_FANOUT},
+    };
+    const int count = sizeof(configs) / sizeof(configs[0]);
+
+    // the graph is only read from here on, so every worker shares it
+    std::vector<Schedule> results(count);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < count; i++) {
+        workers.emplace_back([this, &results, i]() {
+            results[i] = listSchedule(configs[i].dir, rankNodes(configs[i].dir, configs[i].tie));
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    // first config wins ties, so the plain forward schedule is kept unless beaten
+    int best = 0;
+    for (int i = 1; i < count; i++) {
+        if (results[i].size() < results[best].size())
+            best = i;
+    }
+    return std::move(results[best]);
+}
+
+void Scheduler::rankFromKeys(const std::vector<long long>& key, bool forward,
+                             std::vector<int>& order, std::vector<int>& rank) {
+    int n = key.size();
+    order.resize(n);
+    for (int i = 0; i < n; i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&key, forward](int a, int b) {
+        if (key[a] != key[b])
+            return key[a] > key[b];
+        return forward ? a < b : a > b;
+    });
+
+    rank.resize(n);
+    for (int i = 0; i < n; i++)
+        rank[order[i]] = n - i;
+}
+
+Schedule Scheduler::scheduleWithBudget(const Schedule& start, int budgetMs) const {
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(budgetMs);
+
+    // path lengths are scaled so the noise can reorder ops that are close
+    // without swapping ops whose paths differ by more than `spread` cycles
+    const long long SCALE = 16;
+
+    unsigned worker_count = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Schedule> results(worker_count);
+
+    auto worker = [this, deadline, SCALE, &results](unsigned w) {
+        std::mt19937 rng(434u + w);  // fixed seeds: runs differ only in timing
+        Schedule& best = results[w];
+
+        // every restart refills the worker's own buffers
+        std::vector<long long> key(graph.nodes.size());
+        std::vector<int> order, rank;
+        ListBuffers buffers;
+        Schedule candidate;
+
+        while (Clock::now() < deadline) {
+            bool forward = (rng() & 1) == 0;
+            long long spread = 1 + rng() % 6;
+            for (auto* node : graph.nodes) {
+                long long path = forward ? node->priority : node->depth;
+                key[node->id] = path * SCALE + (long long)(rng() % (spread * SCALE));
+            }
+
+            rankFromKeys(key, forward, order, rank);
+            // a restart cut short by the deadline is dropped
+            if (!listScheduleInto(candidate, forward ? SCHEDULE_FORWARD : SCHEDULE_BACKWARD,
+                                  rank, 0, buffers, deadline))
+                break;
+            if (best.empty() || candidate.size() < best.size())
+                std::swap(best, candidate);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < worker_count; w++)
+        workers.emplace_back(worker, w);
+    for (auto& t : workers) t.join();
+
+    Schedule best = start;
+    for (auto& result : results) {
+        if (!result.empty() && result.size() < best.size())
+            best = std::move(result);
+    }
+    return best;
+}
+
+void Scheduler::printSchedule(const Schedule& sched, std::ostream& out) const {
+    for (const Bundle& bundle : sched) {
+        out << "[ ";
+        printOp(out, bundle[0] ? bundle[0]->ir : nullptr);
+        out << " ; ";
+        printOp(out, bundle[1] ? bundle[1]->ir : nullptr);
+        out << " ]\n";
+    }
+}
+
+void Scheduler::printReport(const Schedule& sched, int criticalPath, std::ostream& out) const {
+    // issue cycle of every op in `sched`
+    std::vector<int> issued(graph.nodes.size(), 0);
+    for (size_t cycle = 0; cycle < sched.size(); cycle++) {
+        for (SchedulerNode* node : sched[cycle]) {
+            if (node) issued[node->id] = (int)cycle + 1;
+        }
+    }
+
+    // resource bound: two ops per cycle, memory only on f0, mult only on f1,
+    // one output per cycle
+    int memory = 0, mult = 0, output = 0, critical = 0;
+    for (auto* node : graph.nodes) {
+        switch (node->ir->opcode) {
+            case TOKEN_LOAD:
+            case TOKEN_STORE:  memory++; break;
+            case TOKEN_MULT:   mult++;   break;
+            case TOKEN_OUTPUT: output++; break;
+            default: break;
+        }
+        if (node->slack == 0) critical++;
+    }
+    int resourceBound = std::max({((int)graph.nodes.size() + 1) / 2, memory, mult, output});
+    int lowerBound = std::max(criticalPath, resourceBound);
+    int achieved = (int)sched.size();
+
+    out << "ops:            " << graph.nodes.size() << " (" << critical << " on a critical path)\n";
+    out << "critical path:  " << criticalPath << " cycles\n";
+    out << "resource bound: " << resourceBound << " cycles (" << memory << " memory ops on f0, "
+              << mult << " mults on f1, " << output << " outputs)\n";
+    out << "lower bound:    " << lowerBound << " cycles\n";
+    out << "achieved:       " << achieved << " cycles\n";
+    out << "gap:            " << achieved - lowerBound << " cycles";
+    if (lowerBound > 0) {
+        long long permille = (long long)(achieved - lowerBound) * 1000 / lowerBound;
+        out << " (" << permille / 10 << "." << permille % 10 << "% above the lower bound)";
+    }
+    out << "\n\n";
+
+    out << "   id   line  prio  earliest  slack  issued  op\n";
+    for (auto* node : graph.nodes) {
+        out << (node->slack == 0 ? '*' : ' ');
+        out.width(4);  out << node->id << "  ";
+        out.width(5);  out << node->ir->line << "  ";
+        out.width(4);  out << node->priority << "  ";
+        out.width(8);  out << node->earliest << "  ";
+        out.width(5);  out << node->slack << "  ";
+        out.width(6);  out << issued[node->id] << "  ";
+        printOp(out, node->ir);
+        out << "\n";
+    }
+}
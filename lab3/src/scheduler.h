@@ -2,52 +2,131 @@
 
 #include "parser.h"
 #include <vector>
-#include <queue>
-#include <map>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <memory>
 
 struct SchedulerNode {
     IRNode* ir;
     int id;
-    int priority;
+    int priority;       // latency-weighted path length to a sink (forward rank)
+    int depth;          // latency-weighted path length from a root (backward rank)
+    int descendants;    // estimated number of nodes below this one
+    int ancestors;      // estimated number of nodes above this one
+    int earliest;       // first cycle the op can issue (ASAP)
+    int slack;          // cycles the op can slip without lengthening the critical path
     int latency;
     int in_degree;
     std::vector<SchedulerNode*> children;
     std::vector<SchedulerNode*> parents;
 
-    // Track when this instruction will be completed
-    int ready_at_cycle;
-
     SchedulerNode(IRNode* node, int node_id);
+    void reset(IRNode* node, int node_id);   // reuse for another op; keeps edge capacity
 };
 
 class DependencyGraph {
 public:
     DependencyGraph();
-    void build(IRNode* head);
+    DependencyGraph(const DependencyGraph&) = delete;
+    DependencyGraph& operator=(const DependencyGraph&) = delete;
+    void build(IRNode* head);  // replaces any earlier graph; nodes and tables are reused
     void computePriorities();
+    void computeTieBreakers(); // depth, descendants, ancestors
+    int computeSlack();        // earliest, slack; returns the critical-path length
+    void writeDot(std::ostream& out) const;
     std::vector<SchedulerNode*> getRoots();
     std::vector<SchedulerNode*> nodes;
 
 private:
+    // the graph owns its nodes; a rebuild reuses them and their edge lists
+    std::vector<std::unique_ptr<SchedulerNode>> pool;
+    std::vector<SchedulerNode*> lastDef;                // last writer per VR (RAW / WAW)
+    std::vector<std::vector<SchedulerNode*>> lastUses;  // readers since then (WAR)
+    std::vector<SchedulerNode*> loadsSinceStore;
+
     void addEdge(SchedulerNode* from, SchedulerNode* to);
 };
 
+// direction a list schedule is built in
+enum ScheduleDirection {
+    SCHEDULE_FORWARD,   // roots first, cycle 1 upward
+    SCHEDULE_BACKWARD,  // sinks first, then reversed
+};
+
+// secondary key used when two ready ops have the same path length
+enum TieBreaker {
+    TIE_ID,             // original program order
+    TIE_DESCENDANTS,    // more dependent work first
+    TIE_FANOUT,         // more immediate successors first
+};
+
+// one cycle: the op issued on f0 and the op issued on f1 (nullptr = nop)
+using Bundle = std::array<SchedulerNode*, 2>;
+using Schedule = std::vector<Bundle>;
+
+// one op in ILOC syntax with its VRs; nullptr prints as nop
+void printOp(std::ostream& out, const IRNode* node);
+
 class Scheduler {
 public:
     Scheduler(DependencyGraph& dg);
-    void schedule();
+
+    // forward list schedule with the latency-weighted priority
+    Schedule schedule() const;
+
+    // forward and backward list schedules with every tie-breaker, run on
+    // worker threads; returns the one with the fewest cycles
+    Schedule scheduleBest() const;
+
+    // randomized restarts: perturb the path lengths on every hardware thread
+    // until budgetMs has passed and keep the shortest schedule, starting
+    // from `start`. A restart still running at the deadline is dropped; the
+    // budget can still overrun by one ranking, a sort of the block's ops
+    Schedule scheduleWithBudget(const Schedule& start, int budgetMs) const;
+
+    // forward list schedule that tracks the number of live values and, once it
+    // gets within one of pressureLimit, issues pressure-reducing ops first
+    Schedule schedulePressure(int pressureLimit) const;
+
+    // list schedule in the given direction; rank[id] orders ready ops
+    // (higher rank issues first) and must be a total order. pressureLimit > 0
+    // enables register-pressure tracking (forward only)
+    Schedule listSchedule(ScheduleDirection dir, const std::vector<int>& rank,
+                          int pressureLimit = 0) const;
+
+    // turn (path length, tie-breaker, id) into a dense rank per node
+    std::vector<int> rankNodes(ScheduleDirection dir, TieBreaker tie) const;
+
+    void printSchedule(const Schedule& sched, std::ostream& out = std::cout) const;
+
+    // critical path, resource bound, per-op slack and the cycles `sched`
+    // achieves; the graph's slack must already be computed
+    void printReport(const Schedule& sched, int criticalPath, std::ostream& out = std::cout) const;
 
 private:
-    DependencyGraph& graph;
-    
-    struct ComparePriority {
-        bool operator()(SchedulerNode* const& n1, SchedulerNode* const& n2) {
-            if (n1->priority != n2->priority)
-                return n1->priority < n2->priority;
-            // Tie breaker: original order (id) or number of children
-            return n1->id > n2->id; 
-        }
+    using Clock = std::chrono::steady_clock;
+
+    // what a list schedule works in; a caller that schedules over and over
+    // keeps one so each run refills it instead of allocating
+    struct ListBuffers {
+        std::vector<int> ready;                       // heap on rank
+        std::vector<std::pair<int, int>> pending;     // heap on (cycle, id)
+        std::vector<int> remaining;                   // unplaced predecessors per node
+        std::vector<int> earliest;                    // first cycle per node
+        std::vector<int> deferred;
+        std::vector<std::pair<int, int>> candidates;  // (pressure delta, id)
     };
 
-    bool canFit(IRNode* ir, int unit); // unit 0 or 1
+    DependencyGraph& graph;
+
+    // listSchedule into sched with the caller's buffers; false, with sched
+    // incomplete, once the deadline has passed
+    bool listScheduleInto(Schedule& sched, ScheduleDirection dir, const std::vector<int>& rank,
+                          int pressureLimit, ListBuffers& buffers, Clock::time_point deadline) const;
+
+    static bool canFit(IRNode* ir, int unit); // unit 0 or 1
+    // rank[id] from key (higher first, then program order); order is scratch
+    static void rankFromKeys(const std::vector<long long>& key, bool forward,
+                             std::vector<int>& order, std::vector<int>& rank);
 };
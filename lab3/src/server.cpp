@@ -0,0 +1,210 @@
+#include "server.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+constexpr char REQUEST_MAGIC[4] = {'I', 'L', 'R', 'Q'};
+constexpr char RESPONSE_MAGIC[4] = {'I', 'L', 'R', 'S'};
+
+// a request bigger than this is refused rather than buffered
+constexpr uint32_t MAX_OPTIONS_BYTES = 64 * 1024;
+constexpr uint64_t MAX_BLOCK_BYTES = 1ull << 30;
+
+struct FrameHeader {
+    char magic[4];
+    uint32_t small;     // options length, or the exit status
+    uint64_t length;    // block or output length
+};
+
+static_assert(sizeof(FrameHeader) == 16, "FrameHeader layout changed");
+
+// the socket to remove when a signal stops the server
+static char boundPath[sizeof(sockaddr_un::sun_path)];
+
+static void stopServer(int) {
+    unlink(boundPath);
+    _exit(0);
+}
+
+static bool readFull(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool writeFull(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size) {
+        // MSG_NOSIGNAL: a client that hung up is an error, not SIGPIPE
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool socketAddress(const std::string& path, sockaddr_un& address) {
+    if (path.size() >= sizeof address.sun_path) return false;
+    std::memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// the buffers one worker reuses for every request it answers
+struct WorkerState {
+    ServerRequest request;
+    std::string options;
+    std::ostringstream out;
+};
+
+static bool readRequest(int fd, WorkerState& state) {
+    FrameHeader header;
+    if (!readFull(fd, &header, sizeof header)) return false;
+    if (std::memcmp(header.magic, REQUEST_MAGIC, sizeof REQUEST_MAGIC) != 0 ||
+        header.small > MAX_OPTIONS_BYTES || header.length > MAX_BLOCK_BYTES)
+        return false;
+
+    state.options.resize(header.small);
+    state.request.block.resize(header.length);
+    if (!readFull(fd, state.options.data(), state.options.size()) ||
+        !readFull(fd, state.request.block.data(), state.request.block.size()))
+        return false;
+
+    // the options arrive '\0'-separated; reuse the strings already there
+    size_t count = 0;
+    for (size_t start = 0; start < state.options.size(); count++) {
+        size_t end = state.options.find('\0', start);
+        if (end == std::string::npos) end = state.options.size();
+        if (count == state.request.options.size()) state.request.options.emplace_back();
+        state.request.options[count].assign(state.options, start, end - start);
+        start = end + 1;
+    }
+    state.request.options.resize(count);
+    return true;
+}
+
+static bool writeResponse(int fd, int status, const std::string& output) {
+    FrameHeader header;
+    std::memcpy(header.magic, RESPONSE_MAGIC, sizeof RESPONSE_MAGIC);
+    header.small = (uint32_t)status;
+    header.length = output.size();
+    return writeFull(fd, &header, sizeof header) && writeFull(fd, output.data(), output.size());
+}
+
+static void serveConnection(int fd, WorkerState& state, const RequestHandler& handler) {
+    while (readRequest(fd, state)) {
+        state.out.str(std::string());
+        state.out.clear();
+        int status;
+        try {
+            status = handler(state.request, state.out);
+        } catch (std::exception& e) {
+            state.out << "Error: " << e.what() << '\n';
+            status = 1;
+        }
+        if (!writeResponse(fd, status, state.out.str())) break;
+    }
+    close(fd);
+}
+
+int serve(const std::string& socketPath, int threads, const RequestHandler& handler) {
+    sockaddr_un address;
+    if (!socketAddress(socketPath, address)) {
+        std::cerr << "Error: socket path too long: " << socketPath << std::endl;
+        return 1;
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Error: socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    // a socket left behind by a server that was killed would make bind fail
+    unlink(socketPath.c_str());
+    if (bind(listener, (sockaddr*)&address, sizeof address) < 0 || listen(listener, 64) < 0) {
+        std::cerr << "Error: cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        close(listener);
+        return 1;
+    }
+
+    std::memcpy(boundPath, address.sun_path, sizeof boundPath);
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+
+    // every worker blocks in accept on the same socket and serves the
+    // connection it gets until the client closes it
+    auto work = [&]() {
+        WorkerState state;
+        for (;;) {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                std::cerr << "Error: accept: " << std::strerror(errno) << std::endl;
+                return;
+            }
+            serveConnection(fd, state, handler);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+
+    close(listener);
+    unlink(socketPath.c_str());
+    return 1;
+}
+
+int connectToServer(const std::string& socketPath) {
+    sockaddr_un address;
+    if (!socketAddress(socketPath, address)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (sockaddr*)&address, sizeof address) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sendRequest(int fd, const ServerRequest& request) {
+    std::string options;
+    for (size_t i = 0; i < request.options.size(); i++) {
+        if (i) options += '\0';
+        options += request.options[i];
+    }
+    if (options.size() > MAX_OPTIONS_BYTES || request.block.size() > MAX_BLOCK_BYTES) return false;
+
+    FrameHeader header;
+    std::memcpy(header.magic, REQUEST_MAGIC, sizeof REQUEST_MAGIC);
+    header.small = (uint32_t)options.size();
+    header.length = request.block.size();
+    return writeFull(fd, &header, sizeof header) && writeFull(fd, options.data(), options.size()) &&
+           writeFull(fd, request.block.data(), request.block.size());
+}
+
+bool receiveResponse(int fd, int& status, std::string& output) {
+    FrameHeader header;
+    if (!readFull(fd, &header, sizeof header) ||
+        std::memcmp(header.magic, RESPONSE_MAGIC, sizeof RESPONSE_MAGIC) != 0)
+        return false;
+    status = (int)header.small;
+    output.resize(header.length);
+    return readFull(fd, output.data(), output.size());
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// --serve: a long-running process that schedules blocks sent over a Unix
+// domain socket, so a small block does not pay for process startup.
+//
+// A connection carries any number of requests, one after another:
+//   request   "ILRQ", uint32 options length, uint64 block length, the
+//             command-line options separated by '\0', then the block
+//             (ILOC text or a .ilir file)
+//   response  "ILRS", uint32 exit status, uint64 output length, then the
+//             output: what schedule would print, or the error messages
+// Integers are in host byte order; both ends are on the same machine.
+
+struct ServerRequest {
+    std::vector<std::string> options;
+    std::string block;
+};
+
+// run one request; returns the exit status and writes the output to out
+using RequestHandler = std::function<int(const ServerRequest& request, std::ostream& out)>;
+
+// listen on socketPath and answer requests on `threads` worker threads
+// until SIGINT or SIGTERM; each worker serves one connection at a time
+// and keeps its buffers between requests. Returns 1 if the socket cannot
+// be set up
+int serve(const std::string& socketPath, int threads, const RequestHandler& handler);
+
+// the client side; connect() returns -1 on failure
+int connectToServer(const std::string& socketPath);
+bool sendRequest(int fd, const ServerRequest& request);
+bool receiveResponse(int fd, int& status, std::string& output);
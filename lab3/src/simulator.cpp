@@ -0,0 +1,337 @@
+#include "simulator.h"
+#include <algorithm>
+#include <array>
+#include <climits>
+
+// ---------------------------------------------------------------------------
+// Decoding
+// ---------------------------------------------------------------------------
+
+Simulator::Simulator() : zeroPage(new Word[PAGE_WORDS]) {
+    pages.assign(PAGE_COUNT, zeroPage.get());
+}
+
+Simulator::Op Simulator::decode(const IRNode* ir) {
+    switch (ir->opcode) {
+        case TOKEN_LOADI:
+        case TOKEN_OUTPUT:
+            return {ir->opcode, ir->sr1, -1, ir->vr3};
+        case TOKEN_LOAD:
+        case TOKEN_STORE:
+            return {ir->opcode, ir->vr1, -1, ir->vr3};
+        case TOKEN_ADD:
+        case TOKEN_SUB:
+        case TOKEN_MULT:
+        case TOKEN_LSHIFT:
+        case TOKEN_RSHIFT:
+            return {ir->opcode, ir->vr1, ir->vr2, ir->vr3};
+        default:
+            return {TOKEN_NOP, -1, -1, -1};
+    }
+}
+
+int Simulator::latencyOf(int32_t opcode) {
+    switch (opcode) {
+        case TOKEN_LOAD:
+        case TOKEN_STORE:
+            return 5;
+        case TOKEN_MULT:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+// size the register file for `ops` and clear all machine state
+void Simulator::reset(const std::vector<Op>& ops) {
+    int32_t max_reg = -1;
+    for (const Op& op : ops) {
+        if (op.opcode == TOKEN_NOP) continue;
+        if (op.opcode != TOKEN_LOADI && op.opcode != TOKEN_OUTPUT)
+            max_reg = std::max({max_reg, op.a, op.b});
+        max_reg = std::max(max_reg, op.c);
+    }
+    registers.assign(max_reg + 1, 0);
+    registerReady.assign(max_reg + 1, 0);
+    registerWrittenBy.assign(max_reg + 1, -1);
+
+    // pages already touched stay mapped for the next run
+    for (const auto& page : ownedPages)
+        std::fill(page.get(), page.get() + PAGE_WORDS, Word());
+}
+
+bool Simulator::wordIndex(int32_t address, uint32_t& word, SimReport& report) const {
+    uint32_t a = (uint32_t)address;
+    if ((a & 3) != 0 || a >= MEMORY_BYTES) {
+        report.ok = false;
+        report.error = "memory access at invalid address " + std::to_string(address);
+        return false;
+    }
+    word = a >> 2;
+    return true;
+}
+
+const Simulator::Word& Simulator::readWord(uint32_t word) const {
+    return pages[word / PAGE_WORDS][word & (PAGE_WORDS - 1)];
+}
+
+Simulator::Word& Simulator::writeWord(uint32_t word) {
+    Word*& page = pages[word / PAGE_WORDS];
+    if (page == zeroPage.get()) {
+        ownedPages.emplace_back(new Word[PAGE_WORDS]);
+        page = ownedPages.back().get();
+    }
+    return page[word & (PAGE_WORDS - 1)];
+}
+
+// ---------------------------------------------------------------------------
+// Execution — an op reads its operands when it issues and its result lands
+// when its latency is up, so both ops of a bundle read before either writes.
+// ---------------------------------------------------------------------------
+namespace {
+
+struct Effect {
+    enum Kind { NONE, REGISTER, MEMORY } kind = NONE;
+    uint32_t target = 0;   // register number or memory word
+    int32_t value = 0;
+};
+
+int32_t lshift(int32_t x, int32_t n) {
+    if (n < 0 || n > 31) return 0;
+    return (int32_t)((uint32_t)x << n);
+}
+
+int32_t rshift(int32_t x, int32_t n) {
+    if (n < 0 || n > 31) return x < 0 ? -1 : 0;
+    return x >> n;
+}
+
+} // namespace
+
+SimReport Simulator::runSequential(IRNode* head) {
+    code.clear();
+    for (IRNode* node = head; node; node = node->next)
+        code.push_back(decode(node));
+    reset(code);
+
+    SimReport report;
+    for (const Op& op : code) {
+        if (op.opcode == TOKEN_NOP) continue;
+        report.ops++;
+
+        uint32_t word;
+        switch (op.opcode) {
+            case TOKEN_LOADI:
+                registers[op.c] = op.a;
+                break;
+            case TOKEN_LOAD:
+                if (!wordIndex(registers[op.a], word, report)) return report;
+                registers[op.c] = readWord(word).value;
+                break;
+            case TOKEN_STORE:
+                if (!wordIndex(registers[op.c], word, report)) return report;
+                writeWord(word).value = registers[op.a];
+                break;
+            case TOKEN_ADD:
+                registers[op.c] = (int32_t)((uint32_t)registers[op.a] + (uint32_t)registers[op.b]);
+                break;
+            case TOKEN_SUB:
+                registers[op.c] = (int32_t)((uint32_t)registers[op.a] - (uint32_t)registers[op.b]);
+                break;
+            case TOKEN_MULT:
+                registers[op.c] = (int32_t)((uint32_t)registers[op.a] * (uint32_t)registers[op.b]);
+                break;
+            case TOKEN_LSHIFT:
+                registers[op.c] = lshift(registers[op.a], registers[op.b]);
+                break;
+            case TOKEN_RSHIFT:
+                registers[op.c] = rshift(registers[op.a], registers[op.b]);
+                break;
+            case TOKEN_OUTPUT:
+                if (!wordIndex(op.a, word, report)) return report;
+                report.output.push_back(readWord(word).value);
+                break;
+            default:
+                break;
+        }
+    }
+    report.cycles = report.ops;
+    report.completionCycle = report.ops;
+    return report;
+}
+
+SimReport Simulator::runSchedule(const Schedule& sched) {
+    static const Op NOP = {TOKEN_NOP, -1, -1, -1};
+
+    code.clear();
+    code.reserve(sched.size() * 2);
+    for (const Bundle& bundle : sched) {
+        code.push_back(bundle[0] ? decode(bundle[0]->ir) : NOP);
+        code.push_back(bundle[1] ? decode(bundle[1]->ir) : NOP);
+    }
+    reset(code);
+
+    // results in flight, in a ring of slots indexed by the cycle they land.
+    // A result lands 1, 3 or 5 cycles after issue and a cycle issues two ops,
+    // so at most six land in one cycle; they are added in issue order, which
+    // is the order they land in
+    struct Pending {
+        long long op;
+        Effect effect;
+    };
+    struct Slot {
+        std::array<Pending, 6> results;
+        int count = 0;
+    };
+    constexpr int RING = 8;   // more than the longest latency
+    std::array<Slot, RING> ring;
+    long long landed = 0;   // every result due by this cycle has landed
+    int inFlight = 0;
+
+    SimReport report;
+
+    // apply every result that has landed by `cycle`; one that lands after
+    // a result of a later op to the same place is a write-after-write
+    // hazard the schedule missed
+    auto land = [&](long long cycle) {
+        while (inFlight > 0 && landed < cycle) {
+            Slot& slot = ring[++landed % RING];
+            for (int r = 0; r < slot.count; r++) {
+                const Pending& p = slot.results[r];
+                const Effect& e = p.effect;
+                if (e.kind == Effect::REGISTER) {
+                    if (registerWrittenBy[e.target] > p.op) report.lateWrites++;
+                    registerWrittenBy[e.target] = p.op;
+                    registers[e.target] = e.value;
+                } else {
+                    Word& w = writeWord(e.target);
+                    if (w.writtenBy > p.op) report.lateWrites++;
+                    w.writtenBy = p.op;
+                    w.value = e.value;
+                }
+            }
+            inFlight -= slot.count;
+            slot.count = 0;
+        }
+        // nothing in flight: the ring is empty, so it can skip ahead
+        if (inFlight == 0 && landed < cycle) landed = cycle;
+    };
+
+    long long cycle = 1;
+
+    for (size_t i = 0; i < code.size(); i += 2) {
+        const Op* slot = &code[i];
+
+        // structural checks: f0 has no multiplier, f1 no memory port
+        if (slot[0].opcode == TOKEN_MULT) report.unitViolations++;
+        if (slot[1].opcode == TOKEN_LOAD || slot[1].opcode == TOKEN_STORE) report.unitViolations++;
+        if (slot[0].opcode == TOKEN_OUTPUT && slot[1].opcode == TOKEN_OUTPUT) report.outputViolations++;
+
+        // interlock: the bundle waits until every write to what it reads
+        // has landed; an address register is read once it is ready
+        long long start = cycle;
+        for (int u = 0; u < 2; u++) {
+            const Op& op = slot[u];
+            switch (op.opcode) {
+                case TOKEN_LOAD:
+                    start = std::max(start, registerReady[op.a]);
+                    break;
+                case TOKEN_STORE:
+                    start = std::max({start, registerReady[op.a], registerReady[op.c]});
+                    break;
+                case TOKEN_ADD:
+                case TOKEN_SUB:
+                case TOKEN_MULT:
+                case TOKEN_LSHIFT:
+                case TOKEN_RSHIFT:
+                    start = std::max({start, registerReady[op.a], registerReady[op.b]});
+                    break;
+                default:
+                    break;
+            }
+        }
+        land(start);
+        for (int u = 0; u < 2; u++) {
+            const Op& op = slot[u];
+            uint32_t word;
+            if (op.opcode == TOKEN_LOAD || op.opcode == TOKEN_OUTPUT) {
+                if (!wordIndex(op.opcode == TOKEN_LOAD ? registers[op.a] : op.a, word, report)) return report;
+                start = std::max(start, readWord(word).ready);
+            }
+        }
+        land(start);
+        report.stallCycles += start - cycle;
+
+        // read phase
+        Effect effects[2];
+        for (int u = 0; u < 2; u++) {
+            const Op& op = slot[u];
+            Effect& e = effects[u];
+            if (op.opcode == TOKEN_NOP) continue;
+            report.ops++;
+
+            uint32_t word;
+            switch (op.opcode) {
+                case TOKEN_LOADI:
+                    e = {Effect::REGISTER, (uint32_t)op.c, op.a};
+                    break;
+                case TOKEN_LOAD:
+                    if (!wordIndex(registers[op.a], word, report)) return report;
+                    e = {Effect::REGISTER, (uint32_t)op.c, readWord(word).value};
+                    break;
+                case TOKEN_STORE:
+                    if (!wordIndex(registers[op.c], word, report)) return report;
+                    e = {Effect::MEMORY, word, registers[op.a]};
+                    break;
+                case TOKEN_ADD:
+                    e = {Effect::REGISTER, (uint32_t)op.c,
+                         (int32_t)((uint32_t)registers[op.a] + (uint32_t)registers[op.b])};
+                    break;
+                case TOKEN_SUB:
+                    e = {Effect::REGISTER, (uint32_t)op.c,
+                         (int32_t)((uint32_t)registers[op.a] - (uint32_t)registers[op.b])};
+                    break;
+                case TOKEN_MULT:
+                    e = {Effect::REGISTER, (uint32_t)op.c,
+                         (int32_t)((uint32_t)registers[op.a] * (uint32_t)registers[op.b])};
+                    break;
+                case TOKEN_LSHIFT:
+                    e = {Effect::REGISTER, (uint32_t)op.c, lshift(registers[op.a], registers[op.b])};
+                    break;
+                case TOKEN_RSHIFT:
+                    e = {Effect::REGISTER, (uint32_t)op.c, rshift(registers[op.a], registers[op.b])};
+                    break;
+                case TOKEN_OUTPUT:
+                    if (!wordIndex(op.a, word, report)) return report;
+                    report.output.push_back(readWord(word).value);
+                    break;
+                default:
+                    break;
+            }
+            report.completionCycle = std::max(report.completionCycle, start + latencyOf(op.opcode) - 1);
+        }
+
+        // issue phase: each result is queued to land when its latency is
+        // up, and readers of its target wait until then
+        for (int u = 0; u < 2; u++) {
+            const Effect& e = effects[u];
+            if (e.kind == Effect::NONE) continue;
+            long long ready = start + latencyOf(slot[u].opcode);
+            if (e.kind == Effect::REGISTER) {
+                registerReady[e.target] = std::max(registerReady[e.target], ready);
+            } else {
+                Word& w = writeWord(e.target);
+                w.ready = std::max(w.ready, ready);
+            }
+            Slot& slot = ring[ready % RING];
+            slot.results[slot.count++] = {(long long)(i + u), e};
+            inFlight++;
+        }
+
+        cycle = start + 1;
+    }
+    land(LLONG_MAX);
+
+    report.cycles = cycle - 1;
+    return report;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "scheduler.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Outcome of one simulated run
+struct SimReport {
+    bool ok = true;                  // ran to the end without a fault
+    std::string error;               // first fault, when !ok
+    std::vector<int32_t> output;     // values printed by output ops, in order
+    long long ops = 0;               // ops executed (nops excluded)
+    long long cycles = 0;            // issue cycles, stalls included
+    long long stallCycles = 0;       // cycles spent waiting on an unfinished result
+    long long unitViolations = 0;    // ops issued on a unit that cannot run them
+    long long outputViolations = 0;  // cycles with more than one output
+    long long lateWrites = 0;        // writes that landed after a later op's write to the same place
+    long long completionCycle = 0;   // cycle in which the last result is available
+};
+
+// ILOC execution model used to check schedules: two functional units,
+// load/store take 5 cycles, mult 3, everything else 1. Registers are the
+// renamed VRs; memory is words in 4 KB pages allocated on the first store.
+// Issue is in order with interlocks: a cycle whose operands are not ready
+// yet stalls, and the stall is reported. A result lands in its register or
+// word only when its latency is up, so a slow write issued before a fast
+// one to the same place lands last and wins, as on the hardware.
+class Simulator {
+public:
+    static constexpr uint32_t MEMORY_BYTES = 1u << 24;
+
+    Simulator();
+
+    // reference run: every op in program order, no timing
+    SimReport runSequential(IRNode* head);
+
+    // timed run of a schedule, one bundle per cycle
+    SimReport runSchedule(const Schedule& sched);
+
+private:
+    // predecoded op; registers and immediates already pulled out of the IR
+    struct Op {
+        int32_t opcode;
+        int32_t a, b, c;   // loadI/output: a = immediate; otherwise VRs
+    };
+
+    // a memory word
+    struct Word {
+        int32_t value = 0;
+        long long ready = 0;       // cycle the last pending store to it lands
+        long long writtenBy = -1;  // op index of the store that landed last
+    };
+
+    static constexpr uint32_t PAGE_WORDS = 1024;
+    static constexpr uint32_t PAGE_COUNT = MEMORY_BYTES / 4 / PAGE_WORDS;
+
+    std::vector<Op> code;
+    std::vector<int32_t> registers;
+    std::vector<long long> registerReady;    // cycle every pending write to it has landed
+    std::vector<long long> registerWrittenBy; // op index of the write that landed last
+
+    std::vector<Word*> pages;   // zeroPage until a store touches the page
+    std::vector<std::unique_ptr<Word[]>> ownedPages;
+    std::unique_ptr<Word[]> zeroPage;
+
+    static Op decode(const IRNode* ir);
+    static int latencyOf(int32_t opcode);
+    void reset(const std::vector<Op>& ops);
+    bool wordIndex(int32_t address, uint32_t& word, SimReport& report) const;
+    const Word& readWord(uint32_t word) const;
+    Word& writeWord(uint32_t word);
+};
@@ -0,0 +1,135 @@
+#include "stats.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <sys/resource.h>
+
+// Allocation counting replaces the global operator new; new[] and the
+// nothrow forms call it too. Counting stays off unless --stats is given,
+// so other runs pay one relaxed load per allocation.
+static std::atomic<bool> counting(false);
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> allocationBytes(0);
+
+void* operator new(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void* p = std::malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static double wallNowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static double cpuNowMs() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static long peakRssKb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  // kilobytes on Linux
+}
+
+PhaseStats::PhaseStats(const std::string& tool, bool enabled)
+    : tool(tool), on(enabled), wallStart(0), cpuStart(0) {
+    if (!on) return;
+    counting.store(true, std::memory_order_relaxed);
+    wallStart = wallNowMs();
+    cpuStart = cpuNowMs();
+}
+
+PhaseStats::Scope::Scope(PhaseStats& stats, const char* name)
+    : stats(stats), name(name), wallStart(0), cpuStart(0), allocationsStart(0), bytesStart(0) {
+    if (!stats.on) return;
+    allocationsStart = allocationCount.load(std::memory_order_relaxed);
+    bytesStart = allocationBytes.load(std::memory_order_relaxed);
+    cpuStart = cpuNowMs();
+    wallStart = wallNowMs();
+}
+
+PhaseStats::Scope::~Scope() {
+    if (!stats.on) return;
+    double wallMs = wallNowMs() - wallStart;
+    double cpuMs = cpuNowMs() - cpuStart;
+    stats.record(name, wallMs, cpuMs,
+                 allocationCount.load(std::memory_order_relaxed) - allocationsStart,
+                 allocationBytes.load(std::memory_order_relaxed) - bytesStart);
+}
+
+void PhaseStats::record(const char* name, double wallMs, double cpuMs, uint64_t allocations, uint64_t bytes) {
+    Phase* phase = nullptr;
+    for (Phase& p : phases) {
+        if (p.name == name) phase = &p;
+    }
+    if (!phase) {
+        phases.push_back({name, 0, 0.0, 0.0, 0, 0, 0});
+        phase = &phases.back();
+    }
+    phase->runs++;
+    phase->wallMs += wallMs;
+    phase->cpuMs += cpuMs;
+    phase->allocations += allocations;
+    phase->bytes += bytes;
+    phase->peakRssKb = peakRssKb();
+}
+
+void PhaseStats::print(std::ostream& out, bool json) const {
+    if (!on) return;
+    double wallMs = wallNowMs() - wallStart;
+    double cpuMs = cpuNowMs() - cpuStart;
+    uint64_t allocations = allocationCount.load(std::memory_order_relaxed);
+    uint64_t bytes = allocationBytes.load(std::memory_order_relaxed);
+    long rss = peakRssKb();
+
+    char line[256];
+    if (json) {
+        out << "{\"tool\":\"" << tool << "\",\"phases\":[";
+        for (size_t i = 0; i < phases.size(); i++) {
+            const Phase& p = phases[i];
+            std::snprintf(line, sizeof line,
+                          "%s{\"name\":\"%s\",\"runs\":%d,\"wall_ms\":%.3f,\"cpu_ms\":%.3f,"
+                          "\"allocations\":%llu,\"allocated_bytes\":%llu,\"peak_rss_kb\":%ld}",
+                          i ? "," : "", p.name.c_str(), p.runs, p.wallMs, p.cpuMs,
+                          (unsigned long long)p.allocations, (unsigned long long)p.bytes, p.peakRssKb);
+            out << line;
+        }
+        std::snprintf(line, sizeof line,
+                      "],\"total\":{\"wall_ms\":%.3f,\"cpu_ms\":%.3f,"
+                      "\"allocations\":%llu,\"allocated_bytes\":%llu,\"peak_rss_kb\":%ld}}",
+                      wallMs, cpuMs, (unsigned long long)allocations, (unsigned long long)bytes, rss);
+        out << line << std::endl;
+        return;
+    }
+
+    std::snprintf(line, sizeof line, "%-14s %5s %11s %11s %12s %14s %12s\n",
+                  "phase", "runs", "wall ms", "cpu ms", "allocations", "bytes", "peak RSS KB");
+    out << line;
+    for (const Phase& p : phases) {
+        std::snprintf(line, sizeof line, "%-14s %5d %11.3f %11.3f %12llu %14llu %12ld\n",
+                      p.name.c_str(), p.runs, p.wallMs, p.cpuMs,
+                      (unsigned long long)p.allocations, (unsigned long long)p.bytes, p.peakRssKb);
+        out << line;
+    }
+    std::snprintf(line, sizeof line, "%-14s %5s %11.3f %11.3f %12llu %14llu %12ld\n",
+                  "total", "", wallMs, cpuMs,
+                  (unsigned long long)allocations, (unsigned long long)bytes, rss);
+    out << line << std::flush;
+}
@@ -0,0 +1,198 @@
+#include "cgen.h"
+#include <set>
+#include <sstream>
+
+// everything the function body needs but the block itself
+static const char* const PRELUDE =
+    "#include <stdint.h>\n"
+    "#include <string.h>\n"
+    "\n"
+    "#ifndef ILOC_ENTRY\n"
+    "#define ILOC_ENTRY iloc_run\n"
+    "#endif\n"
+    "\n"
+    "#ifndef ILOC_MACHINE\n"
+    "#define ILOC_MACHINE\n"
+    "/* the machine a block runs on; memory holds memory_bytes bytes, zero on entry */\n"
+    "struct iloc_machine {\n"
+    "    uint8_t* memory;\n"
+    "    uint32_t memory_bytes;\n"
+    "    void (*output)(void* context, int32_t value);\n"
+    "    void* context;\n"
+    "    uint32_t fault_address;   /* set when the block returns 1 */\n"
+    "};\n"
+    "#endif\n"
+    "\n"
+    "#define ILOC_CHECK(address) \\\n"
+    "    if (((address) & 3) || (address) > m->memory_bytes - 4) { m->fault_address = (address); return 1; }\n"
+    "\n"
+    "/* a count past 31 shifts every bit out */\n"
+    "static inline int32_t iloc_lshift(int32_t x, int32_t n) {\n"
+    "    return (uint32_t)n > 31 ? 0 : (int32_t)((uint32_t)x << n);\n"
+    "}\n"
+    "\n"
+    "static inline int32_t iloc_rshift(int32_t x, int32_t n) {\n"
+    "    return x >> ((uint32_t)n > 31 ? 31 : n);\n"
+    "}\n"
+    "\n";
+
+static const char* const MAIN =
+    "\n"
+    "#ifdef ILOC_MAIN\n"
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "\n"
+    "#ifndef ILOC_MEMORY_BYTES\n"
+    "#define ILOC_MEMORY_BYTES (1u << 24)\n"
+    "#endif\n"
+    "\n"
+    "static void iloc_print(void* context, int32_t value) {\n"
+    "    (void)context;\n"
+    "    printf(\"%d\\n\", value);\n"
+    "}\n"
+    "\n"
+    "int main(void) {\n"
+    "    struct iloc_machine m = {calloc(ILOC_MEMORY_BYTES, 1), ILOC_MEMORY_BYTES, iloc_print, NULL, 0};\n"
+    "    if (!m.memory) return 2;\n"
+    "    if (ILOC_ENTRY(&m)) {\n"
+    "        fflush(stdout);\n"
+    "        fprintf(stderr, \"Error: memory access at invalid address %d\\n\", (int32_t)m.fault_address);\n"
+    "        return 1;\n"
+    "    }\n"
+    "    return 0;\n"
+    "}\n"
+    "#endif\n";
+
+static const char* binaryOperator(TokenType opcode) {
+    switch (opcode) {
+        case TOKEN_ADD: return "+";
+        case TOKEN_SUB: return "-";
+        case TOKEN_MULT: return "*";
+        default: return nullptr;
+    }
+}
+
+void printC(const IRNode* head, const std::vector<std::string>& labels,
+            const std::string& source, std::ostream& out) {
+    // a prepass for the declarations: registers, scratch locals and the
+    // labels some branch targets (C warns about the others)
+    std::set<int> registers;
+    std::set<int> read;      // registers some op reads (C warns about the others)
+    std::set<int> targets;
+    bool memory = false;
+    bool output = false;   // only output reads a word into v
+    for (const IRNode* node = head; node; node = node->next) {
+        switch (node->opcode) {
+            case TOKEN_LOADI:
+                registers.insert(node->sr3);
+                break;
+            case TOKEN_LOAD:
+                registers.insert({node->sr1, node->sr3});
+                read.insert(node->sr1);
+                memory = true;
+                break;
+            case TOKEN_STORE:
+                registers.insert({node->sr1, node->sr3});
+                read.insert({node->sr1, node->sr3});
+                memory = true;
+                break;
+            case TOKEN_ADD:
+            case TOKEN_SUB:
+            case TOKEN_MULT:
+            case TOKEN_LSHIFT:
+            case TOKEN_RSHIFT:
+                registers.insert({node->sr1, node->sr2, node->sr3});
+                read.insert({node->sr1, node->sr2});
+                break;
+            case TOKEN_OUTPUT:
+                memory = true;
+                output = true;
+                break;
+            case TOKEN_JUMPI:
+                targets.insert(node->sr1);
+                break;
+            case TOKEN_CBR:
+                registers.insert(node->sr1);
+                read.insert(node->sr1);
+                targets.insert({node->sr2, node->sr3});
+                break;
+            default:
+                break;
+        }
+    }
+
+    std::ostringstream body;
+    body << "/* ILOC block " << source << ", translated by 434makeup -c */\n";
+    body << PRELUDE;
+    body << "int ILOC_ENTRY(struct iloc_machine* m) {\n";
+    if (memory) {
+        body << "    uint8_t* const memory = m->memory;\n";
+        body << "    uint32_t a;\n";
+        if (output) body << "    int32_t v;\n";
+    } else {
+        body << "    (void)m;\n";
+    }
+    int column = 0;
+    for (int reg : registers) {
+        body << (column == 0 ? "    int32_t " : ", ") << "r" << reg << " = 0";
+        if (++column == 8) {
+            body << ";\n";
+            column = 0;
+        }
+    }
+    if (column) body << ";\n";
+    for (int reg : registers) {
+        if (!read.count(reg)) body << "    (void)r" << reg << ";\n";
+    }
+    body << "\n";
+
+    for (const IRNode* node = head; node; node = node->next) {
+        int a = node->sr1, b = node->sr2, c = node->sr3;
+        switch (node->opcode) {
+            case TOKEN_LOADI:
+                body << "    r" << c << " = " << a << ";\n";
+                break;
+            case TOKEN_LOAD:
+                body << "    a = (uint32_t)r" << a << "; ILOC_CHECK(a); memcpy(&r" << c << ", memory + a, 4);\n";
+                break;
+            case TOKEN_STORE:
+                body << "    a = (uint32_t)r" << c << "; ILOC_CHECK(a); memcpy(memory + a, &r" << a << ", 4);\n";
+                break;
+            case TOKEN_ADD:
+            case TOKEN_SUB:
+            case TOKEN_MULT:
+                // unsigned, so overflow wraps as it does in ILOC
+                body << "    r" << c << " = (int32_t)((uint32_t)r" << a << " " << binaryOperator(node->opcode)
+                     << " (uint32_t)r" << b << ");\n";
+                break;
+            case TOKEN_LSHIFT:
+                body << "    r" << c << " = iloc_lshift(r" << a << ", r" << b << ");\n";
+                break;
+            case TOKEN_RSHIFT:
+                body << "    r" << c << " = iloc_rshift(r" << a << ", r" << b << ");\n";
+                break;
+            case TOKEN_OUTPUT:
+                body << "    a = " << (uint32_t)a << "u; ILOC_CHECK(a); memcpy(&v, memory + a, 4); "
+                     << "m->output(m->context, v);\n";
+                break;
+            case TOKEN_LABEL:
+                if (targets.count(a)) body << "L_" << labels[a] << ":;\n";
+                else body << "/* " << labels[a] << ": */\n";
+                break;
+            case TOKEN_JUMPI:
+                body << "    goto L_" << labels[a] << ";\n";
+                break;
+            case TOKEN_CBR:
+                body << "    if (r" << a << ") goto L_" << labels[b] << "; else goto L_" << labels[c] << ";\n";
+                break;
+            default:
+                break;   // nop
+        }
+    }
+
+    body << "    return 0;\n";
+    body << "}\n";
+    body << "\n#undef ILOC_CHECK\n";
+    body << MAIN;
+    out << body.str();
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "parser.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Print the block at head as C, for ahead-of-time native builds. The block
+// becomes one function, int iloc_run(struct iloc_machine*), with a local
+// int32_t per register, memcpy on a byte array for memory and goto for
+// branches; it returns 0, or 1 after a misaligned or out-of-range access.
+// Compiled with -DILOC_MAIN the file also gets a main() that prints the
+// output values one per line, as ilocrun does. labels holds the label
+// names by id; source names the ILOC file in the header comment.
+void printC(const IRNode* head, const std::vector<std::string>& labels,
+            const std::string& source, std::ostream& out);
@@ -9,8 +9,22 @@ void print_help() {
               << "  -h          Print this help message and exit.\n"
               << "  <file>      Scan, parse, and optimize the ILOC block in <file> using\n"
               << "              Local Value Numbering; print the optimized code to stdout.\n"
+              << "  -m <file>   Optimize as above, but keep loads of words known to hold a\n"
+              << "              constant as loads (skip the constant memory stage).\n"
               << "  -p <file>   Scan and parse <file>; print the unchanged code to stdout\n"
               << "              (no optimization performed — used to measure optimizer overhead).\n"
+              << "  -c          With any of the above, print the block as a C function\n"
+              << "              (iloc_run) instead of ILOC; compile it with -O2 to run the\n"
+              << "              block natively, and with -DILOC_MAIN for a program that\n"
+              << "              prints its output values one per line.\n"
+              << "  --stats[=json]\n"
+              << "              With any of the above, also print wall and CPU time,\n"
+              << "              allocations and peak RSS for each phase to stderr, as a\n"
+              << "              table or as one JSON object.\n"
+              << "\n"
+              << "A file may hold several blocks: a label (L1:) starts one, and\n"
+              << "jumpI -> L1 or cbr r1 -> L1, L2 ends one. Value numbering then\n"
+              << "runs over extended basic blocks.\n"
               << "\n"
               << "All error messages are written to stderr.\n";
 }
@@ -19,6 +33,26 @@ CLIOptions parse_arguments(int argc, char* argv[]) {
     CLIOptions result;
     result.valid = true;
     result.k     = 0;
+    result.constantMemory = true;
+    result.emitC = false;
+    result.stats = false;
+    result.statsJson = false;
+
+    // --stats and -c may go anywhere; take them out before matching the forms below
+    std::vector<char*> args;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (i > 0 && (arg == "--stats" || arg == "--stats=json")) {
+            result.stats     = true;
+            result.statsJson = (arg == "--stats=json");
+        } else if (i > 0 && arg == "-c") {
+            result.emitC = true;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    argc = (int)args.size();
+    argv = args.data();
 
     // -h
     if (argc == 2 && std::string(argv[1]) == "-h") {
@@ -33,6 +67,14 @@ CLIOptions parse_arguments(int argc, char* argv[]) {
         return result;
     }
 
+    // -m <file>
+    if (argc == 3 && std::string(argv[1]) == "-m") {
+        result.mode           = MODE_OPT;
+        result.filename       = std::string(argv[2]);
+        result.constantMemory = false;
+        return result;
+    }
+
     // <file>
     if (argc == 2) {
         std::string arg(argv[1]);
@@ -47,6 +89,6 @@ CLIOptions parse_arguments(int argc, char* argv[]) {
     }
 
     result.valid        = false;
-    result.errorMessage = "Usage: 434makeup -h | 434makeup <file> | 434makeup -p <file>";
+    result.errorMessage = "Usage: 434makeup -h | 434makeup [-m] <file> | 434makeup -p <file> [-c] [--stats[=json]]";
     return result;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 enum Mode {
     MODE_HELP,
@@ -15,6 +16,10 @@ struct CLIOptions {
     Mode mode;
     std::string filename;
     int k;
+    bool constantMemory;   // -m turns off the LVN constant memory stage
+    bool emitC;            // -c: print the block as C instead of ILOC
+    bool stats;            // --stats: per-phase time and memory on stderr
+    bool statsJson;        // --stats=json: the same as one JSON object
     bool valid;
     std::string errorMessage;
 };
@@ -1,10 +1,360 @@
 #include "lvn.h"
 #include <iostream>
 #include <algorithm>
-#include <unordered_set>
+#include <iterator>
 
+// tag used in place of an opcode for constant keys
+static const uint64_t CONST_TAG = 0xFFFFFFFFull;
 
-LVN::LVN() : nextVN(0) {}  //constructor
+// register an op writes, or -1
+static int destination(const IRNode* n) {
+    switch (n->opcode) {
+        case TOKEN_LOADI:
+        case TOKEN_LOAD:
+        case TOKEN_ADD:
+        case TOKEN_SUB:
+        case TOKEN_MULT:
+        case TOKEN_LSHIFT:
+        case TOKEN_RSHIFT:
+            return n->sr3;
+        default:
+            return -1;
+    }
+}
+
+// registers an op reads, into reads[]; returns how many
+static int sources(const IRNode* n, int reads[2]) {
+    switch (n->opcode) {
+        case TOKEN_ADD:
+        case TOKEN_SUB:
+        case TOKEN_MULT:
+        case TOKEN_LSHIFT:
+        case TOKEN_RSHIFT:
+            reads[0] = n->sr1;
+            reads[1] = n->sr2;
+            return 2;
+        case TOKEN_STORE:
+            reads[0] = n->sr1;
+            reads[1] = n->sr3;
+            return 2;
+        case TOKEN_LOAD:
+        case TOKEN_CBR:
+            reads[0] = n->sr1;
+            return 1;
+        default: // loadI and output hold a constant in sr1, labels and jumpI a label id
+            return 0;
+    }
+}
+
+// largest register an op names, or -1
+static int highestRegister(const IRNode* n) {
+    int reads[2];
+    int count = sources(n, reads);
+    int high = destination(n);
+    for (int i = 0; i < count; i++) {
+        high = std::max(high, reads[i]);
+    }
+    return high;
+}
+
+
+// ValueTable
+
+// size the table so `count` keys stay under half full
+void ValueTable::reserve(size_t count) {
+    size_t capacity = 16;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    if (capacity > slots.size()) {
+        grow(capacity);
+    }
+}
+
+// mix both words (splitmix64 finalizer) so nearby VNs spread over the table
+size_t ValueTable::hash(const ExprKey& key) {
+    uint64_t h = key.head * 0x9E3779B97F4A7C15ull ^ key.tail;
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBull;
+    h ^= h >> 31;
+    return static_cast<size_t>(h);
+}
+
+// rehash every entry into a table of `capacity` slots (a power of two)
+void ValueTable::grow(size_t capacity) {
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(capacity, Slot());
+    used = 0;
+    for (const Slot& slot : old) {
+        if (slot.vn >= 0) {
+            insert(slot.key, slot.vn);
+        }
+    }
+}
+
+int ValueTable::find(const ExprKey& key) const {
+    if (slots.empty()) {
+        return -1;
+    }
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash(key) & mask; ; i = (i + 1) & mask) {
+        if (slots[i].vn < 0) { // empty slot ends the probe sequence
+            return -1;
+        }
+        if (slots[i].key == key) {
+            return slots[i].vn;
+        }
+    }
+}
+
+void ValueTable::insert(const ExprKey& key, int vn) {
+    if ((used + 1) * 2 > slots.size()) { // keep the load factor at or below 1/2
+        grow(slots.empty() ? 16 : slots.size() * 2);
+    }
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash(key) & mask; ; i = (i + 1) & mask) {
+        if (slots[i].vn < 0) {
+            slots[i].key = key;
+            slots[i].vn = vn;
+            used++;
+            return;
+        }
+        if (slots[i].key == key) {
+            slots[i].vn = vn;
+            return;
+        }
+    }
+}
+
+
+LVN::LVN(bool constantMemory)
+    : nextVN(0), nextReg(0), constEpoch(0), symbolicEpoch(0), constantMemory(constantMemory),
+      scoped(false) {}  //constructor
+
+// prepass: size every table for the op list so the forward pass never
+// allocates, and record how long each defined value is needed
+void LVN::prepare(IRNode* head) {
+    size_t ops = 0;
+    size_t mults = 0;
+    int maxReg = -1;
+    for (IRNode* n = head; n; n = n->next) {
+        ops++;
+        if (n->opcode == TOKEN_MULT) {
+            mults++;
+        }
+        maxReg = std::max(maxReg, highestRegister(n));
+    }
+
+    buildBlocks(head);
+    scoped = blocks.size() > 1;
+    undoLog.clear();
+    std::vector<std::vector<int>> liveOut = liveOutSets(maxReg);
+
+    // backward walk over each block: the def is seen before the uses of the
+    // same op, since an op reads its operands before it writes its result.
+    // A register live out of the block is read after all of it
+    int total = static_cast<int>(ops);
+    const int LIVE_OUT = total + 1;
+    lastUse.assign(ops, -1);
+    nextDef.assign(ops, total);
+    std::vector<int> useSeen(maxReg + 1, -1);
+    std::vector<int> defSeen(maxReg + 1, total);
+    std::vector<int> touched; // entries of useSeen / defSeen to reset after the block (scoped only)
+    size_t liveInVNs = 0;
+
+    for (size_t b = 0; b < blocks.size(); b++) {
+        const Block& block = blocks[b];
+        for (int reg : liveOut[b]) {
+            useSeen[reg] = LIVE_OUT;
+            touched.push_back(reg);
+        }
+
+        size_t reads = 0;
+        int index = block.start + block.count;
+        IRNode* n = block.last;
+        for (int k = 0; k < block.count; k++, n = n->prev) {
+            index--;
+            int dest = destination(n);
+            if (dest >= 0) {
+                lastUse[index] = useSeen[dest];
+                nextDef[index] = defSeen[dest];
+                useSeen[dest] = -1;
+                defSeen[dest] = index;
+                if (scoped) {
+                    touched.push_back(dest);
+                }
+            }
+            int regs[2];
+            int count = sources(n, regs);
+            for (int i = 0; i < count; i++) {
+                if (useSeen[regs[i]] < 0) {
+                    useSeen[regs[i]] = index;
+                }
+                if (scoped) {
+                    touched.push_back(regs[i]);
+                }
+            }
+            reads += count;
+        }
+        // a register gets a VN on its first read in a block, when none reached it
+        liveInVNs += std::min(reads, static_cast<size_t>(maxReg + 1));
+
+        for (int reg : touched) {
+            useSeen[reg] = -1;
+            defSeen[reg] = total;
+        }
+        touched.clear();
+    }
+
+    // each op creates at most one VN, plus the live-in VNs above; each mult
+    // rewritten to lshift may add a shift count and a register
+    size_t maxVN = ops + liveInVNs + mults;
+    size_t regs = static_cast<size_t>(maxReg) + 1 + mults;
+    nextReg = maxReg + 1;
+
+    registerToVN.assign(regs, -1);
+    vnReg.assign(maxVN, -1);
+    vnToConst.assign(maxVN, std::nullopt);
+    exprToVN.reserve(ops);
+    memValue.assign(maxVN, -1);
+    memEpoch.assign(maxVN, -1);
+    regDeadAt.assign(regs, total); // valueNumberBlock sets it for the registers a block writes
+}
+
+// split the op list into blocks: a label starts one, a branch ends one.
+// A block without a branch falls through to the next
+void LVN::buildBlocks(IRNode* head) {
+    blocks.clear();
+    std::vector<int> labelBlock; // label id -> block it starts
+
+    IRNode* prev = nullptr;
+    int index = 0;
+    for (IRNode* n = head; n; prev = n, n = n->next, index++) {
+        bool afterBranch = prev && (prev->opcode == TOKEN_JUMPI || prev->opcode == TOKEN_CBR);
+        if (blocks.empty() || n->opcode == TOKEN_LABEL || afterBranch) {
+            blocks.push_back({n, n, index, 0, {}, 0});
+        }
+        Block& block = blocks.back();
+        block.last = n;
+        block.count++;
+
+        if (n->opcode == TOKEN_LABEL) {
+            if (static_cast<int>(labelBlock.size()) <= n->sr1) {
+                labelBlock.resize(n->sr1 + 1, -1);
+            }
+            labelBlock[n->sr1] = static_cast<int>(blocks.size()) - 1;
+        }
+    }
+
+    auto target = [&labelBlock](int label) {
+        return (label >= 0 && label < static_cast<int>(labelBlock.size())) ? labelBlock[label] : -1;
+    };
+    for (size_t b = 0; b < blocks.size(); b++) {
+        const IRNode* last = blocks[b].last;
+        std::vector<int> successors;
+        if (last->opcode == TOKEN_JUMPI) {
+            successors.push_back(target(last->sr1));
+        } else if (last->opcode == TOKEN_CBR) {
+            successors.push_back(target(last->sr2));
+            successors.push_back(target(last->sr3));
+        } else if (b + 1 < blocks.size()) {
+            successors.push_back(static_cast<int>(b) + 1);
+        }
+
+        for (int successor : successors) {
+            if (successor >= 0) {
+                blocks[b].successors.push_back(successor);
+                blocks[successor].predecessors++;
+            }
+        }
+    }
+}
+
+// registers live on exit from each block, as sorted lists: iterate
+// in = exposed uses + (out - writes), out = union of successors' in, to a
+// fixpoint. Nothing is live past the end of the list
+std::vector<std::vector<int>> LVN::liveOutSets(int maxReg) const {
+    size_t count = blocks.size();
+    std::vector<std::vector<int>> liveOut(count);
+    if (count < 2) {
+        return liveOut;
+    }
+
+    std::vector<std::vector<int>> exposed(count); // read before any write in the block
+    std::vector<std::vector<int>> written(count);
+    std::vector<int> exposedIn(maxReg + 1, -1); // register -> last block it was added to
+    std::vector<int> writtenIn(maxReg + 1, -1);
+    for (size_t b = 0; b < count; b++) {
+        int block = static_cast<int>(b);
+        IRNode* n = blocks[b].first;
+        for (int k = 0; k < blocks[b].count; k++, n = n->next) {
+            int regs[2];
+            int reads = sources(n, regs);
+            for (int i = 0; i < reads; i++) {
+                if (writtenIn[regs[i]] != block && exposedIn[regs[i]] != block) {
+                    exposedIn[regs[i]] = block;
+                    exposed[b].push_back(regs[i]);
+                }
+            }
+            int dest = destination(n);
+            if (dest >= 0 && writtenIn[dest] != block) {
+                writtenIn[dest] = block;
+                written[b].push_back(dest);
+            }
+        }
+        std::sort(exposed[b].begin(), exposed[b].end());
+        std::sort(written[b].begin(), written[b].end());
+    }
+
+    std::vector<std::vector<int>> liveIn(count);
+    std::vector<int> out, in, merged;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = count; b-- > 0;) {
+            out.clear();
+            for (int successor : blocks[b].successors) {
+                merged.clear();
+                std::set_union(out.begin(), out.end(), liveIn[successor].begin(), liveIn[successor].end(),
+                               std::back_inserter(merged));
+                out.swap(merged);
+            }
+
+            in.clear();
+            std::set_difference(out.begin(), out.end(), written[b].begin(), written[b].end(),
+                                std::back_inserter(in));
+            merged.clear();
+            std::set_union(in.begin(), in.end(), exposed[b].begin(), exposed[b].end(),
+                           std::back_inserter(merged));
+            if (merged != liveIn[b]) {
+                liveIn[b].swap(merged);
+                changed = true;
+            }
+            liveOut[b] = out;
+        }
+    }
+    return liveOut;
+}
+
+// write a table entry, logging the old value while blocks are scoped
+void LVN::set(std::vector<int>& table, int index, int value) {
+    int& slot = table[index];
+    if (scoped) {
+        undoLog.push_back({&slot, slot});
+    }
+    slot = value;
+}
+
+// undo table writes back to the log length `mark`
+void LVN::undoTo(size_t mark) {
+    while (undoLog.size() > mark) {
+        *undoLog.back().slot = undoLog.back().value;
+        undoLog.pop_back();
+    }
+}
 
 // new value number
 int LVN::newVN() { return nextVN++; }
@@ -16,13 +366,12 @@ int LVN::getVN(int reg) {
     }
 
     // find existing VN for this register
-    auto it = registerToVN.find(reg);
-    if (it != registerToVN.end()) {
-        return it->second;
+    if (registerToVN[reg] >= 0) {
+        return registerToVN[reg];
     }
 
     int vn = newVN();
-    registerToVN[reg] = vn; // assign new VN to this register
+    set(registerToVN, reg, vn); // assign new VN to this register
     return vn;
 }
 
@@ -33,15 +382,11 @@ void LVN::define(int reg, int vn) {
     }
 
     // finding old VN for this register,
-    auto old = registerToVN.find(reg);
-    if (old != registerToVN.end()) { // if not found
-        int oldVN = old->second; 
-        auto cr = vnReg.find(oldVN); // find the register that oldVN maps to and erase it
-        if (cr != vnReg.end() && cr->second == reg) {
-            vnReg.erase(cr);
-        }
+    int oldVN = registerToVN[reg];
+    if (oldVN >= 0 && vnReg[oldVN] == reg) { // if this register held oldVN, it no longer does
+        set(vnReg, oldVN, -1);
     }
-    registerToVN[reg] = vn; // assign new VN to this register
+    set(registerToVN, reg, vn); // assign new VN to this register
 }
 
 
@@ -52,45 +397,73 @@ int LVN::canonical(int reg) const {
     }
 
     // find register that maps to the same VN as this register
-    auto rv = registerToVN.find(reg);
-    if (rv == registerToVN.end()) { // if not found, return original register
+    int vn = registerToVN[reg];
+    if (vn < 0) { // if not found, return original register
         return reg;
     }
 
-    auto cr = vnReg.find(rv->second); // find the register that maps to the same VN as this register
-    if (cr == vnReg.end()) { // if not found, return original register
+    int holder = vnReg[vn]; // find the register that maps to the same VN as this register
+    if (holder < 0) { // if not found, return original register
         return reg;
     }
 
-    return cr->second; // return the canonical register that maps to the same VN as this register
+    return holder; // return the canonical register that maps to the same VN as this register
 }
 
-// get a string key for an expression (op, vn1, vn2)
-std::string LVN::exprKey(TokenType op, int vn1, int vn2) const {
+// get the key for an expression (op, vn1, vn2)
+ExprKey LVN::exprKey(TokenType op, int vn1, int vn2) const {
     if (op == TOKEN_ADD || op == TOKEN_MULT) { // order add and mult operands in ascending order
         if (vn1 > vn2) {
             std::swap(vn1, vn2);
         }
     }
-    //return string key
-    return std::to_string(static_cast<int>(op)) + "," + std::to_string(vn1) + "," + std::to_string(vn2); 
+    return {static_cast<uint64_t>(op) << 32 | static_cast<uint32_t>(vn1),
+            static_cast<uint32_t>(vn2)};
+}
+
+// get the key for a constant
+ExprKey LVN::constKey(long long value) const {
+    return {CONST_TAG << 32, static_cast<uint64_t>(value)};
+}
+
+// get the value number of a constant, creating it on first sight
+int LVN::constVN(long long value) {
+    ExprKey key = constKey(value);
+    int vn = exprToVN.find(key);
+    if (vn < 0) { // if not found, create new VN and record it
+        vn = newVN();
+        exprToVN.insert(key, vn);
+        vnToConst[vn] = value;
+    }
+    return vn;
 }
 
-// fold 2 constants for an operation
+// fold 2 constants for an operation, with the 32-bit arithmetic the
+// machine does, so every constant in vnToConst is a value a register can hold
 std::optional<long long> LVN::fold(TokenType op, long long c1, long long c2) const {
+    uint32_t a = static_cast<uint32_t>(c1);
+    uint32_t b = static_cast<uint32_t>(c2);
+    int32_t  count = static_cast<int32_t>(b);
+
     switch (op) { // only fold if both operands are constants
 
         case TOKEN_ADD:    
-            return c1 + c2;
+            return static_cast<int32_t>(a + b);
         case TOKEN_SUB:   
-            return c1 - c2;
+            return static_cast<int32_t>(a - b);
         case TOKEN_MULT:   
-            return c1 * c2;
+            return static_cast<int32_t>(a * b);
 
-        case TOKEN_LSHIFT:  //shifts need casting to avoid negative shift counts and sign-extension issues
-            return static_cast<long long>(static_cast<unsigned long long>(c1) << c2);
-        case TOKEN_RSHIFT: 
-            return static_cast<long long>(static_cast<unsigned long long>(c1) >> c2);
+        case TOKEN_LSHIFT:  // shifting by 32 or more (or a negative count) clears the register
+            if (count < 0 || count > 31) {
+                return 0;
+            }
+            return static_cast<int32_t>(a << count);
+        case TOKEN_RSHIFT:  // arithmetic shift; large counts leave only the sign
+            if (count < 0 || count > 31) {
+                return static_cast<int32_t>(a) < 0 ? -1 : 0;
+            }
+            return static_cast<int32_t>(a) >> count;
 
         //if not a foldable operation, return nullopt
         default:           
@@ -98,6 +471,128 @@ std::optional<long long> LVN::fold(TokenType op, long long c1, long long c2) con
     }
 }
 
+// algebraic identities that need only one constant operand (or none)
+int LVN::identity(TokenType op, int vn1, int vn2) const {
+    const std::optional<long long>& c1 = vnToConst[vn1];
+    const std::optional<long long>& c2 = vnToConst[vn2];
+
+    switch (op) {
+        case TOKEN_ADD:
+            if (c2 == 0) return 1; // x + 0
+            if (c1 == 0) return 2; // 0 + x
+            break;
+        case TOKEN_SUB:
+            if (c2 == 0) return 1; // x - 0
+            if (vn1 == vn2) return 0; // x - x
+            break;
+        case TOKEN_MULT:
+            if (c1 == 0 || c2 == 0) return 0; // x * 0
+            if (c2 == 1) return 1; // x * 1
+            if (c1 == 1) return 2; // 1 * x
+            break;
+        case TOKEN_LSHIFT:
+        case TOKEN_RSHIFT:
+            if (c2 == 0) return 1; // x << 0, x >> 0
+            if (c1 == 0) return 0; // 0 << x, 0 >> x
+            break;
+        default:
+            break;
+    }
+    return -1;
+}
+
+// an op whose value already sits in `holder` can be dropped only if holder
+// is not overwritten before the op's result is last read
+bool LVN::canAlias(int holder, int dest, int index) const {
+    return holder == dest || lastUse[index] <= regDeadAt[holder];
+}
+
+// reg names vn from now on; its readers are rewritten to holder by canonical()
+void LVN::alias(int reg, int vn, int holder) {
+    define(reg, vn);
+    if (vnReg[vn] < 0) {
+        set(vnReg, vn, holder);
+    }
+}
+
+// transform node into a loadI of value and number its result
+void LVN::rewriteAsConstant(IRNode* node, long long value) {
+    node->opcode = TOKEN_LOADI;
+    node->sr1 = static_cast<int>(value);
+    node->sr2 = -1;
+
+    int vn = constVN(value); // reuse this constant's VN, or create one
+    define(node->sr3, vn);
+    if (vnReg[vn] < 0) {
+        set(vnReg, vn, node->sr3);
+    }
+}
+
+// x * 2^k => x << k: returns k, or -1 if c is not a power of two
+static int powerOfTwo(const std::optional<long long>& c) {
+    if (!c || *c <= 1 || (*c & (*c - 1)) != 0) {
+        return -1;
+    }
+    int k = 0;
+    while ((1LL << k) != *c) {
+        k++;
+    }
+    return k;
+}
+
+// a register holding `value` before `node`; when none does, a loadI into a
+// register the block never uses is inserted ahead of node
+int LVN::constantRegister(long long value, IRNode* node, IRNode*& head) {
+    int vn = constVN(value);
+    if (vnReg[vn] >= 0) {
+        return vnReg[vn];
+    }
+
+    IRNode* load = new IRNode();
+    load->line = node->line;
+    load->opcode = TOKEN_LOADI;
+    load->sr1 = static_cast<int>(value);
+    load->sr3 = nextReg++;
+
+    load->prev = node->prev;
+    load->next = node;
+    if (node->prev) {
+        node->prev->next = load;
+    } else {
+        head = load;
+    }
+    node->prev = load;
+
+    define(load->sr3, vn); // never redefined, so regDeadAt stays past the block
+    set(vnReg, vn, load->sr3);
+    return load->sr3;
+}
+
+// memory value numbering. Every address is a VN; two constant VNs are two
+// different words, but a non-constant VN may be any word. Entries are
+// stamped with the epoch of their kind, and bumping an epoch forgets every
+// entry of that kind at once.
+
+// VN of the word at addrVN, or -1 if it is unknown
+int LVN::memoryValue(int addrVN) const {
+    int epoch = vnToConst[addrVN] ? constEpoch : symbolicEpoch;
+    return memEpoch[addrVN] == epoch ? memValue[addrVN] : -1;
+}
+
+// the word at addrVN now holds valueVN
+void LVN::recordMemory(int addrVN, int valueVN) {
+    set(memValue, addrVN, valueVN);
+    set(memEpoch, addrVN, vnToConst[addrVN] ? constEpoch : symbolicEpoch);
+}
+
+// a store to addrVN: forget every word it may overwrite
+void LVN::invalidateMemory(int addrVN) {
+    symbolicEpoch++; // a non-constant address may equal any address
+    if (!vnToConst[addrVN]) {
+        constEpoch++; // and a store through one may hit any constant address
+    }
+}
+
 // remove a node from the IR linked list and return new head
 IRNode* LVN::removeNode(IRNode* node, IRNode* head) {
     if (node->prev) { // fix prev's next pointer
@@ -120,11 +615,78 @@ IRNode* LVN::removeNode(IRNode* node, IRNode* head) {
 }
 
 
-// main LVN forward pass
+// superlocal value numbering. An extended basic block is a root block
+// (the entry, or one with several predecessors or none) and the tree of
+// single-predecessor blocks below it. Walking that tree depth first, each
+// block starts from the tables its parent left, so values computed on the
+// path to it are reused; leaving it undoes its writes for the next sibling
 IRNode* LVN::lvnPass(IRNode* head) {
+    struct Scope {
+        int block;
+        size_t undoMark; // undo log length on entry
+        int constEpoch; // epochs on entry
+        int symbolicEpoch;
+        size_t nextChild; // next successor to try
+    };
+    std::vector<bool> visited(blocks.size(), false);
+    std::vector<Scope> path;
+
+    auto enter = [&](int b) {
+        visited[b] = true;
+        path.push_back({b, undoLog.size(), constEpoch, symbolicEpoch, 0});
+        head = valueNumberBlock(blocks[b], head);
+    };
+
+    // roots first; then cycles of single-predecessor blocks no root reaches
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t root = 0; root < blocks.size(); root++) {
+            bool isRoot = root == 0 || blocks[root].predecessors != 1;
+            if (visited[root] || (pass == 0 && !isRoot)) {
+                continue;
+            }
+
+            enter(static_cast<int>(root));
+            while (!path.empty()) {
+                Scope& scope = path.back();
+                const std::vector<int>& successors = blocks[scope.block].successors;
+                if (scope.nextChild < successors.size()) {
+                    int child = successors[scope.nextChild++];
+                    if (!visited[child] && blocks[child].predecessors == 1) {
+                        enter(child);
+                    }
+                    continue;
+                }
 
-    IRNode* node = head;
-    while (node) { //iterate through IR nodes
+                undoTo(scope.undoMark);
+                constEpoch = scope.constEpoch;
+                symbolicEpoch = scope.symbolicEpoch;
+                path.pop_back();
+            }
+        }
+    }
+
+    return head;
+}
+
+// value number one block, its parent's tables in place
+IRNode* LVN::valueNumberBlock(const Block& block, IRNode* head) {
+    // a register this block writes is dead at its first write here; any
+    // other register outlives the block (reset on the way out when other
+    // blocks follow)
+    std::vector<int> written;
+    IRNode* node = block.last;
+    for (int index = block.start + block.count - 1; index >= block.start; index--, node = node->prev) {
+        int dest = destination(node);
+        if (dest >= 0) {
+            regDeadAt[dest] = index;
+            if (scoped) {
+                written.push_back(dest);
+            }
+        }
+    }
+
+    node = block.first;
+    for (int index = block.start; index < block.start + block.count; index++) { //iterate through the block's nodes
         IRNode* next = node->next;
 
         switch (node->opcode) { // handle each opcode type
@@ -132,22 +694,13 @@ IRNode* LVN::lvnPass(IRNode* head) {
             // load immediate
             case TOKEN_LOADI: {
                 long long constVal = static_cast<long long>(node->sr1); // get constant value from sr1
-                std::string key = "CONST," + std::to_string(constVal); // create key for this constant
-
-                int vn; 
-                auto eit = exprToVN.find(key); // check if this constant already has a VN
-                if (eit != exprToVN.end()) { // if found, reuse existing VN
-                    vn = eit->second;
-                } else { // if not found, create new VN and record it
-                    vn = newVN();
-                    exprToVN[key] = vn;
-                    vnToConst[vn] = constVal;
-                }
+                int vn = constVN(constVal); // reuse this constant's VN, or create one
+                regDeadAt[node->sr3] = nextDef[index];
 
                 // define that sr3 has this VN, and record that this VN maps to sr3
                 define(node->sr3, vn);
-                if (vnReg.find(vn) == vnReg.end()) { // set vnReg mapping if not already set
-                    vnReg[vn] = node->sr3;
+                if (vnReg[vn] < 0) { // set vnReg mapping if not already set
+                    set(vnReg, vn, node->sr3);
                 }
 
                 break;
@@ -167,68 +720,98 @@ IRNode* LVN::lvnPass(IRNode* head) {
                 int vn1 = getVN(node->sr1);
                 int vn2 = getVN(node->sr2);
 
+                int dest = node->sr3;
+                regDeadAt[dest] = nextDef[index]; // sr3's new value lives until its next def
+
                 // check if both operands are constants
-                auto c1it = vnToConst.find(vn1);
-                auto c2it = vnToConst.find(vn2);
+                const std::optional<long long>& c1 = vnToConst[vn1];
+                const std::optional<long long>& c2 = vnToConst[vn2];
 
-                if (c1it != vnToConst.end() && c2it != vnToConst.end()) { // if both operands are constants, try to fold
-                    auto result = fold(node->opcode, c1it->second, c2it->second);
+                if (c1 && c2) { // if both operands are constants, try to fold
+                    auto result = fold(node->opcode, *c1, *c2);
 
                     if (result.has_value()) { // if fold succeeded, 
-
-                        long long folded = result.value(); // get folded constant value
-
                         // transform this node into a loadI of the folded constant
-                        node->opcode = TOKEN_LOADI;
-                        node->sr1 = static_cast<int>(folded);
-                        node->sr2 = -1;
-
-                        // check if this folded constant already has a VN
-                        std::string ckey = "CONST," + std::to_string(folded);
-
-                        int vn;
-                        auto ceit = exprToVN.find(ckey);
-                        if (ceit != exprToVN.end()) { // if found, reuse existing VN
-                            vn = ceit->second;
-                        } else { // if not found, create new VN and record it
-                            vn = newVN();
-                            exprToVN[ckey] = vn;
-                            vnToConst[vn]  = folded;
-                        }
-
-                        define(node->sr3, vn);
-                        if (vnReg.find(vn) == vnReg.end()) {
-                            vnReg[vn] = node->sr3;
-                        }
+                        rewriteAsConstant(node, result.value());
                         break;
                     }
                 }
 
-                // if not foldable
-                std::string key = exprKey(node->opcode, vn1, vn2); // create key for this expression
-
-                auto eit = exprToVN.find(key);
-                if (eit != exprToVN.end()) { // if found, reuse existing VN 
-
-                    int existingVN  = eit->second;
-                    auto rit = vnReg.find(existingVN);
+                // algebraic identities: the result is a value we already have
+                int holder = -1;
+                int same = identity(node->opcode, vn1, vn2);
+                int sameVN = -1;
 
-                    if (rit != vnReg.end()) { // if the existing VN maps to a register, reuse that register
+                if (same == 0) { // result is the constant 0: reuse a register holding it, or loadI
+                    sameVN = constVN(0);
+                    holder = vnReg[sameVN];
+                    if (holder < 0 || !canAlias(holder, dest, index)) {
+                        rewriteAsConstant(node, 0);
+                        break;
+                    }
+                } else if (same > 0) { // result is one of the operands
+                    sameVN = (same == 1) ? vn1 : vn2;
+                    holder = vnReg[sameVN];
+                    if (holder < 0) { // the operand register itself holds it
+                        holder = (same == 1) ? node->sr1 : node->sr2;
+                    }
+                }
 
-                        define(node->sr3, existingVN);
-                        // Remove this node as its value is already computed.
+                if (sameVN >= 0) {
+                    if (canAlias(holder, dest, index)) {
+                        // no instruction: readers of sr3 use holder instead
+                        alias(dest, sameVN, holder);
                         head = removeNode(node, head);
                         node = next;
                         continue;
                     }
+                    // holder is overwritten while sr3 is still needed: keep the op as a copy
+                    define(dest, sameVN);
+                    break;
+                }
+
+                // strength reduction: mult is 3 cycles on one unit, lshift 1 on either
+                if (node->opcode == TOKEN_MULT) {
+                    int k2 = powerOfTwo(vnToConst[vn2]);
+                    int k1 = powerOfTwo(vnToConst[vn1]);
+                    if (k2 >= 0 || k1 >= 0) {
+                        if (k2 < 0) { // 2^k * x: the variable operand goes first
+                            std::swap(node->sr1, node->sr2);
+                            std::swap(vn1, vn2);
+                            k2 = k1;
+                        }
+                        node->opcode = TOKEN_LSHIFT;
+                        node->sr2 = constantRegister(k2, node, head);
+                        vn2 = constVN(k2);
+                    }
+                }
+
+                // if not foldable
+                ExprKey key = exprKey(node->opcode, vn1, vn2); // create key for this expression
+
+                int existingVN = exprToVN.find(key);
+                if (existingVN >= 0) { // if found, reuse existing VN 
+
+                    int existing = vnReg[existingVN];
+                    if (existing >= 0) { // if the existing VN maps to a register, reuse that register
+                        define(dest, existingVN);
+                        if (canAlias(existing, dest, index)) {
+                            // Remove this node as its value is already computed.
+                            head = removeNode(node, head);
+                            node = next;
+                            continue;
+                        }
+                        // that register is overwritten before sr3's last use: recompute
+                        break;
+                    }
                 }
 
                 // create new VN for this expression and record it
                 int vn = newVN();
-                exprToVN[key] = vn;
+                exprToVN.insert(key, vn);
 
-                define(node->sr3, vn);
-                vnReg[vn] = node->sr3;
+                define(dest, vn);
+                set(vnReg, vn, dest);
                 break;
             }
 
@@ -236,9 +819,34 @@ IRNode* LVN::lvnPass(IRNode* head) {
             case TOKEN_LOAD: {
                 // get canonical register for source
                 node->sr1 = canonical(node->sr1);
+                int addrVN = getVN(node->sr1);
+                node->vr1 = addrVN; // for dead store elimination
+                int dest = node->sr3;
+                regDeadAt[dest] = nextDef[index];
+
+                // the word was stored or loaded before: reuse that value
+                int known = memoryValue(addrVN);
+                if (known >= 0) {
+                    int holder = vnReg[known];
+                    if (holder >= 0 && canAlias(holder, dest, index)) {
+                        // Remove this node as the value is already in a register.
+                        define(dest, known);
+                        head = removeNode(node, head);
+                        node = next;
+                        continue;
+                    }
+                    node->vr3 = known; // for the constant memory stage
+                    define(dest, known); // still loaded, but numbered as the known value
+                    if (vnReg[known] < 0) {
+                        set(vnReg, known, dest);
+                    }
+                    break;
+                }
+
                 int vn = newVN();
-                define(node->sr3, vn); //use fresh VN and define it for sr3
-                vnReg[vn] = node->sr3;
+                define(dest, vn); //use fresh VN and define it for sr3
+                set(vnReg, vn, dest);
+                recordMemory(addrVN, vn);
                 break;
             }
 
@@ -247,10 +855,24 @@ IRNode* LVN::lvnPass(IRNode* head) {
                 // get canonical registers for source and destination
                 node->sr1 = canonical(node->sr1);
                 node->sr3 = canonical(node->sr3);
+
+                int valueVN = getVN(node->sr1);
+                int addrVN = getVN(node->sr3);
+                node->vr3 = addrVN; // for dead store elimination
+                if (vnReg[valueVN] < 0) { // sr1 holds the value, so a later load can reuse it
+                    set(vnReg, valueVN, node->sr1);
+                }
+                invalidateMemory(addrVN);
+                recordMemory(addrVN, valueVN);
                 break;
             }
 
-            // do nothing for output and nop
+            // a branch reads its condition
+            case TOKEN_CBR:
+                node->sr1 = canonical(node->sr1);
+                break;
+
+            // do nothing for output, nop, labels and jumpI
             case TOKEN_OUTPUT:
             case TOKEN_NOP:
             default:
@@ -260,69 +882,139 @@ IRNode* LVN::lvnPass(IRNode* head) {
         node = next; // move to next node 
     }
 
+    for (int reg : written) {
+        regDeadAt[reg] = static_cast<int>(lastUse.size());
+    }
     return head;
 }
 
-// backward dead code elimination pass
+// constant memory stage. lvnPass numbers each load it keeps with the value
+// of its word (vr3) when an earlier store or load in the block determined it;
+// if that value is a constant, a 1-cycle loadI, free to issue on either
+// unit, replaces the 5-cycle load, and the store that fed it may then die
+void LVN::constantLoadPass(IRNode* head) {
+    for (IRNode* n = head; n; n = n->next) {
+        if (n->opcode != TOKEN_LOAD || n->vr3 < 0 || !vnToConst[n->vr3]) {
+            continue;
+        }
+        n->opcode = TOKEN_LOADI;
+        n->sr1 = static_cast<int>(*vnToConst[n->vr3]);
+        n->vr1 = -1; // no longer reads memory
+    }
+}
+
+// backward dead code elimination pass, one block at a time from the
+// registers live out of it. Within a block one sweep reaches the fixpoint:
+// a removed op never marks its operands live, so the ops feeding only it
+// are found dead when the walk reaches them. Liveness across blocks is
+// computed once, before anything is removed.
+// Stores are dead too when a later store in the block overwrites the same
+// constant address before anything can read it.
 IRNode* LVN::deadCodeElimination(IRNode* head) {
-    bool changed = true;
-    while (changed) {
-        changed = false; // change flag to track if we removed any nodes in this iteration
- 
-        // Walk to tail
-        IRNode* n = head;
-        while (n && n->next) n = n->next;
- 
-        std::unordered_set<int> live; // set of live registers
- 
-        while (n) {
+    // size the live set by the largest register
+    int maxReg = -1;
+    size_t memoryOps = 0;
+    for (IRNode* n = head; n; n = n->next) {
+        if (n->opcode == TOKEN_STORE || n->opcode == TOKEN_LOAD || n->opcode == TOKEN_OUTPUT) {
+            memoryOps++;
+        }
+        maxReg = std::max(maxReg, highestRegister(n));
+    }
+
+    buildBlocks(head); // lvnPass moved and removed ops; the labels and branches are as they were
+    std::vector<std::vector<int>> liveOut = liveOutSets(maxReg);
+
+    std::vector<uint64_t> live((maxReg + 64) / 64, 0); // bitset of live registers
+    std::vector<int> touched; // registers set live in the current block
+    auto isLive = [&live](int reg) {
+        return (live[reg >> 6] >> (reg & 63)) & 1;
+    };
+    auto setLive = [&live, &touched](int reg) {
+        if (reg >= 0) {
+            live[reg >> 6] |= uint64_t(1) << (reg & 63);
+            touched.push_back(reg);
+        }
+    };
+    auto clearLive = [&live](int reg) {
+        live[reg >> 6] &= ~(uint64_t(1) << (reg & 63));
+    };
+
+    // constant address of a load or store, from the address VN lvnPass
+    // recorded in vr1 / vr3 (-1 when the pass did not see the op)
+    auto constantAddress = [this](int vn) -> std::optional<long long> {
+        if (vn < 0 || vn >= static_cast<int>(vnToConst.size())) {
+            return std::nullopt;
+        }
+        return vnToConst[vn];
+    };
+
+    // constant addresses a later store overwrites before any read: an entry
+    // is current when it holds `epoch`; a read through an unknown address
+    // bumps the epoch, since it may read any word, and so does each block
+    // boundary, since a successor may read any word
+    ValueTable overwritten;
+    overwritten.reserve(memoryOps);
+    int epoch = 1;
+    const int READ = 0; // the address is read later
+
+    for (size_t b = blocks.size(); b-- > 0;) {
+        for (int reg : liveOut[b]) {
+            setLive(reg);
+        }
+        epoch++;
+
+        IRNode* n = blocks[b].last;
+        for (int k = 0; k < blocks[b].count; k++) {
             IRNode* prev = n->prev;
- 
-            bool hasSideEffect = (n->opcode == TOKEN_STORE || n->opcode == TOKEN_OUTPUT);
-            int dest = -1;
 
-            // determine destination register for this instruction
-            switch (n->opcode) {
-                case TOKEN_LOADI:
-                case TOKEN_LOAD:
-                case TOKEN_ADD: 
-                case TOKEN_SUB: 
-                case TOKEN_MULT:
-                case TOKEN_LSHIFT: 
-                case TOKEN_RSHIFT:
-                    dest = n->sr3; 
-                    break;
-                default: break;
+            if (n->opcode == TOKEN_STORE) {
+                std::optional<long long> addr = constantAddress(n->vr3);
+                if (addr) {
+                    ExprKey key = constKey(*addr);
+                    if (overwritten.find(key) == epoch) { // overwritten before it is read
+                        head = removeNode(n, head);
+                        n = prev;
+                        continue;
+                    }
+                    overwritten.insert(key, epoch);
+                }
             }
- 
+
+            bool hasSideEffect = (n->opcode == TOKEN_STORE || n->opcode == TOKEN_OUTPUT);
+            int dest = destination(n);
+
             // If instruction has no side effects and its destination is not live, it is dead and can be removed.
-            if (!hasSideEffect && dest >= 0 && live.find(dest) == live.end()) {
+            if (!hasSideEffect && dest >= 0 && !isLive(dest)) {
                 head = removeNode(n, head);
-                changed = true;
                 n = prev;
                 continue;
             }
- 
+
             // Instruction is kept: def kills liveness, uses add liveness.
             if (dest >= 0) {
-                live.erase(dest);
+                clearLive(dest);
             }
- 
-            // Add source registers to live set
+
+            // Add source registers to live set, and addresses read to the memory state
             switch (n->opcode) {
-                case TOKEN_LOAD:
-                    if (n->sr1 >= 0) {
-                        live.insert(n->sr1);
+                case TOKEN_LOAD: {
+                    setLive(n->sr1);
+                    std::optional<long long> addr = constantAddress(n->vr1);
+                    if (addr) {
+                        overwritten.insert(constKey(*addr), READ);
+                    } else {
+                        epoch++;
                     }
                     break;
+                }
+
+                case TOKEN_OUTPUT:
+                    overwritten.insert(constKey(n->sr1), READ);
+                    break;
 
                 case TOKEN_STORE:
-                    if (n->sr1 >= 0) {
-                        live.insert(n->sr1);
-                    }
-                    if (n->sr3 >= 0) {
-                        live.insert(n->sr3);
-                    }
+                    setLive(n->sr1);
+                    setLive(n->sr3);
                     break;
 
                 case TOKEN_ADD: 
@@ -330,20 +1022,25 @@ IRNode* LVN::deadCodeElimination(IRNode* head) {
                 case TOKEN_MULT:
                 case TOKEN_LSHIFT: 
                 case TOKEN_RSHIFT:
-                    if (n->sr1 >= 0) {
-                        live.insert(n->sr1);
-                    }
-                    if (n->sr2 >= 0) {
-                        live.insert(n->sr2);
-                    }
+                    setLive(n->sr1);
+                    setLive(n->sr2);
+                    break;
+
+                case TOKEN_CBR:
+                    setLive(n->sr1);
                     break;
 
                 default: 
                     break;
             }
- 
+
             n = prev; // move to previous node
         }
+
+        for (int reg : touched) { // the next block starts from its own live-out set
+            clearLive(reg);
+        }
+        touched.clear();
     }
     return head; // return new head after DCE
 }
@@ -355,7 +1052,11 @@ IRNode* LVN::optimize(IRNode* head) {
         return head;
     }
 
+    prepare(head); // size the value tables and find lifetimes for this block
     head = lvnPass(head); // first do LVN pass to optimize and annotate with VNs
+    if (constantMemory) {
+        constantLoadPass(head); // loads LVN traced to a constant store become loadIs
+    }
     head = deadCodeElimination(head); // then do DCE pass to remove any dead code exposed by LVN optimizations
 
     return head;
@@ -363,7 +1064,7 @@ IRNode* LVN::optimize(IRNode* head) {
 
 
 // print helpers
-void LVN::printNode(IRNode* node) const {
+void LVN::printNode(IRNode* node, const std::vector<std::string>& labels) const {
     switch (node->opcode) {
         case TOKEN_LOADI:
             std::cout << "loadI " << node->sr1 << " => r" << node->sr3 << "\n";
@@ -392,6 +1093,15 @@ void LVN::printNode(IRNode* node) const {
         case TOKEN_OUTPUT:
             std::cout << "output " << node->sr1 << "\n";
             break;
+        case TOKEN_LABEL:
+            std::cout << labels[node->sr1] << ":\n";
+            break;
+        case TOKEN_JUMPI:
+            std::cout << "jumpI -> " << labels[node->sr1] << "\n";
+            break;
+        case TOKEN_CBR:
+            std::cout << "cbr r" << node->sr1 << " -> " << labels[node->sr2] << ", " << labels[node->sr3] << "\n";
+            break;
 
         case TOKEN_NOP:
             break;
@@ -401,7 +1111,7 @@ void LVN::printNode(IRNode* node) const {
 }
 
 // print the entire IR linked list
-void LVN::printIR(IRNode* head) const {
+void LVN::printIR(IRNode* head, const std::vector<std::string>& labels) const {
     for (IRNode* n = head; n; n = n->next)
-        printNode(n);
+        printNode(n, labels);
 }
\ No newline at end of file
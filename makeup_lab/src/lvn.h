@@ -1,39 +1,126 @@
 #pragma once
 
 #include "parser.h"
-#include <unordered_map>
-#include <string>
+#include <cstdint>
+#include <vector>
 #include <optional>
+#include <string>
+
+// key of a value-numbered expression: (op, vn1, vn2), or (CONST, value) for
+// a constant. Packed into two words so building and hashing it never allocates
+struct ExprKey {
+    uint64_t head; // op tag in the high half, vn1 in the low half
+    uint64_t tail; // vn2, or the constant's bits
+
+    bool operator==(const ExprKey& other) const {
+        return head == other.head && tail == other.tail;
+    }
+};
+
+// open-addressing hash table (linear probing) from ExprKey to value number
+class ValueTable {
+public:
+    void reserve(size_t count); // size for `count` keys without growing
+    int  find(const ExprKey& key) const; // value number, or -1 if absent
+    void insert(const ExprKey& key, int vn); // add or overwrite
+
+private:
+    struct Slot {
+        ExprKey key;
+        int vn = -1; // -1 = empty
+    };
+
+    std::vector<Slot> slots;
+    size_t used = 0;
+
+    static size_t hash(const ExprKey& key);
+    void grow(size_t capacity);
+};
+
+// a basic block: a run of the op list that starts at a label (or after a
+// branch) and ends at a branch (or before the next label)
+struct Block {
+    IRNode* first; // first node (the label, when there is one)
+    IRNode* last; // last node (the branch, when there is one)
+    int start; // index of first in the op list
+    int count; // number of nodes
+    std::vector<int> successors; // block indices
+    int predecessors; // number of incoming edges
+};
 
 class LVN {
 public:
-    LVN(); //constructor
+    explicit LVN(bool constantMemory = true); //constructor; false skips the constant memory stage
 
     // main function: optimize the IR and return new head (may be same as input)
     IRNode* optimize(IRNode* head);
 
-    // Print optimized IR
-    void printIR(IRNode* head) const;
+    // Print optimized IR; labels holds the label names by id
+    void printIR(IRNode* head, const std::vector<std::string>& labels) const;
 
 private:
     int nextVN; //next available value number
+    int nextReg; //first register the block does not use, for inserted loadIs
+    int constEpoch; //current epoch of memory entries at constant addresses
+    int symbolicEpoch; //current epoch of memory entries at computed addresses
+    bool constantMemory; //turn loads of known-constant words into loadIs
+
+    // dense tables sized by a prepass over the block; -1 / nullopt = no entry
+    std::vector<int> registerToVN; // register -> value number
+    std::vector<std::optional<long long>> vnToConst; // value number -> constant value
+    ValueTable exprToVN; // expression key -> value number
+    std::vector<int> vnReg; // value number -> register holding it
+    std::vector<int> memValue; // address VN -> VN of the word stored there
+    std::vector<int> memEpoch; // address VN -> epoch memValue was recorded in
 
-    std::unordered_map<int, int> registerToVN; // map from register to value number
-    std::unordered_map<int, long long> vnToConst; // map from value number to constant value
-    std::unordered_map<std::string, int> exprToVN; // map from expression key to value number
-    std::unordered_map<int, int> vnReg; // map from value number to register
+    // lifetimes from the prepass, by op index in the original list; both
+    // stay inside the op's own block, and a value live out of it is needed
+    // past every op (LIVE_OUT)
+    std::vector<int> lastUse; // last op reading the value this op defines (-1 = none)
+    std::vector<int> nextDef; // next op in the block redefining this op's destination
+    std::vector<int> regDeadAt; // register -> op that next overwrites it, during lvnPass
+
+    // control flow: blocks in list order, and their scope for superlocal
+    // value numbering. Every table write lvnPass makes inside a block is
+    // logged, so leaving the block restores the tables its parent left
+    std::vector<Block> blocks;
+    struct Undo {
+        int* slot;
+        int value;
+    };
+    std::vector<Undo> undoLog;
+    bool scoped; // more than one block, so writes are logged
+
+    void prepare(IRNode* head); // size the tables, find the blocks and record lifetimes
+    void buildBlocks(IRNode* head); // split the list into blocks and link them
+    std::vector<std::vector<int>> liveOutSets(int maxReg) const; // registers live out of each block
+    void set(std::vector<int>& table, int index, int value); // table write, undone on leaving the block
+    void undoTo(size_t mark); // restore the tables to an earlier point
+    IRNode* valueNumberBlock(const Block& block, IRNode* head); // LVN over one block
 
     int  newVN(); // get a new value number
     int  getVN(int reg); // get value number for a register
     void define(int reg, int vn); // define that a register has a value number
 
     int  canonical(int reg) const; // get canonical value number for a register 
-    std::string exprKey(TokenType op, int vn1, int vn2) const; // get a string key for an expression (op, vn1, vn2)
+    ExprKey exprKey(TokenType op, int vn1, int vn2) const; // get the key for an expression (op, vn1, vn2)
+    ExprKey constKey(long long value) const; // get the key for a constant
+    int  constVN(long long value); // get (or create) the value number of a constant
     std::optional<long long> fold(TokenType op, long long c1, long long c2) const; // constant folding for an operation and two constants
+    int  identity(TokenType op, int vn1, int vn2) const; // algebraic identity: 1/2 = that operand, 0 = constant 0, -1 = none
+    bool canAlias(int holder, int dest, int index) const; // can op `index` be dropped, its readers using holder?
+    void alias(int reg, int vn, int holder); // reg now names vn, which holder holds
+    void rewriteAsConstant(IRNode* node, long long value); // turn node into loadI value => sr3
+    int  constantRegister(long long value, IRNode* node, IRNode*& head); // register holding value before node
+
+    int  memoryValue(int addrVN) const; // VN of the word at addrVN, or -1 if unknown
+    void recordMemory(int addrVN, int valueVN); // the word at addrVN holds valueVN
+    void invalidateMemory(int addrVN); // forget every word a store to addrVN may overwrite
 
     IRNode* lvnPass(IRNode* head);   // forward LVN pass
+    void constantLoadPass(IRNode* head); // loads of known-constant words => loadI
     IRNode* deadCodeElimination(IRNode* head); // backward DCE pass 
 
     IRNode* removeNode(IRNode* node, IRNode* head);
-    void printNode(IRNode* node) const;
+    void printNode(IRNode* node, const std::vector<std::string>& labels) const;
 };
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "scanner.h"
 #include "parser.h"
 #include "lvn.h"
+#include "cgen.h"
+#include "stats.h"
 #include "cli.h"
 #include <iostream>
 
@@ -25,17 +27,30 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    PhaseStats stats("434makeup", opts.stats);
+
     try {
         Scanner scanner(opts.filename);
         Parser  parser(scanner);
-        IRNode* ir = parser.parseAll();
+        IRNode* ir = nullptr;
+        {
+            PhaseStats::Scope phase(stats, "scan+parse");
+            ir = parser.parseAll();
+        }
 
         if (opts.mode == MODE_OPT) {
-            LVN lvn;
-            ir = lvn.optimize(ir);
-            lvn.printIR(ir);
+            LVN lvn(opts.constantMemory);
+            {
+                PhaseStats::Scope phase(stats, "lvn");
+                ir = lvn.optimize(ir);
+            }
+            PhaseStats::Scope phase(stats, "emit");
+            if (opts.emitC) printC(ir, parser.labelNames(), opts.filename, std::cout);
+            else lvn.printIR(ir, parser.labelNames());
         } else if (opts.mode == MODE_PARSE_ONLY) {
-            parser.printIR();
+            PhaseStats::Scope phase(stats, "emit");
+            if (opts.emitC) printC(ir, parser.labelNames(), opts.filename, std::cout);
+            else parser.printIR();
         }
 
         freeIR(ir);
@@ -44,5 +59,6 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    stats.print(std::cerr, opts.statsJson);
     return 0;
 }
\ No newline at end of file
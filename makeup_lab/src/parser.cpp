@@ -72,6 +72,33 @@ void Parser::skiptoEOL() {
     }
 }
 
+// label id for a name, assigning the next id on first sight
+int Parser::getLabelId(const std::string& name) {
+    auto found = labelIds.find(name);
+    if (found != labelIds.end()) {
+        return found->second;
+    }
+    int id = static_cast<int>(labels.size());
+    labelIds[name] = id;
+    labels.push_back(name);
+    labelDefinedAt.push_back(-1);
+    labelUsedAt.push_back(-1);
+    return id;
+}
+
+// every branch target must be defined somewhere in the file
+bool Parser::checkLabels() {
+    bool ok = true;
+    for (size_t id = 0; id < labels.size(); id++) {
+        if (labelUsedAt[id] >= 0 && labelDefinedAt[id] < 0) {
+            std::cerr << "Error (line " << labelUsedAt[id] << "): Undefined label "
+                      << labels[id] << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
 // main parse function
 IRNode* Parser::parseAll() {
     bool hasError = false;
@@ -83,6 +110,15 @@ IRNode* Parser::parseAll() {
             continue;
         }
 
+        // a label starts a block; an operation may follow on the same line
+        if (lookahead.type == TOKEN_LABEL) {
+            if (!parseLabel()) {
+                hasError = true;
+                skiptoEOL();
+            }
+            continue;
+        }
+
         //parse operation
         if (!parseOperation()) {
             hasError = true;
@@ -90,6 +126,10 @@ IRNode* Parser::parseAll() {
         }
     }
 
+    if (!checkLabels()) {
+        hasError = true;
+    }
+
     if (hasError) {
         std::cout << "Errors detected" << std::endl;
         return head; //return partial IR
@@ -137,6 +177,14 @@ bool Parser::parseOperation() {
             success = parseNop(node);
             break;
 
+        case TOKEN_JUMPI: // unconditional branch
+            success = parseJumpI(node);
+            break;
+
+        case TOKEN_CBR: // conditional branch
+            success = parseCbr(node);
+            break;
+
         default: // unexpected token
             std::cerr << "Error (line " << lookahead.line << "): Unexpected token " 
                       << lookahead.lexeme << std::endl;
@@ -373,6 +421,110 @@ bool Parser::parseNop(IRNode* node) {
     return true;
 }
 
+// Parse: L1:  (the label node carries the label id in sr1)
+bool Parser::parseLabel() {
+    int id = getLabelId(lookahead.lexeme);
+    if (labelDefinedAt[id] >= 0) {
+        std::cerr << "Error (line " << lookahead.line << "): Label " << lookahead.lexeme
+                  << " already defined on line " << labelDefinedAt[id] << "." << std::endl;
+        return false;
+    }
+    labelDefinedAt[id] = lookahead.line;
+
+    IRNode* node = new IRNode();
+    node->line = lookahead.line;
+    node->opcode = TOKEN_LABEL;
+    node->sr1 = id;
+    lookahead = scanner.nextToken();
+
+    addIRNode(node);
+    return true;
+}
+
+// Parse: jumpI -> L1
+bool Parser::parseJumpI(IRNode* node) {
+    if (!match(TOKEN_JUMPI)) {
+        return false; // if current token is not JUMPI
+    }
+
+    // parse arrow
+    if (!expect(TOKEN_CF_ARROW, "Expected '->' after JUMPI.")) {
+        return false;
+    }
+
+    // get target label
+    if (lookahead.type != TOKEN_NAME) {
+        std::cerr << "Error (line " << lookahead.line << "): Expected label after '->' in JUMPI." << std::endl;
+        return false;
+    }
+    node->sr1 = getLabelId(lookahead.lexeme);
+    if (labelUsedAt[node->sr1] < 0) {
+        labelUsedAt[node->sr1] = lookahead.line;
+    }
+    lookahead = scanner.nextToken();
+
+    // expect end of line
+    if (lookahead.type != TOKEN_EOL && lookahead.type != TOKEN_EOF) {
+        std::cerr << "Error (line " << lookahead.line << "): Expected end of line after JUMPI operation." << std::endl;
+        return false;
+    }
+
+    if (lookahead.type == TOKEN_EOL) {
+        lookahead = scanner.nextToken(); //consume EOL
+    }
+
+    return true;
+}
+
+// Parse: cbr r1 -> L1, L2  (to L1 when r1 is nonzero, else to L2)
+bool Parser::parseCbr(IRNode* node) {
+    if (!match(TOKEN_CBR)) {
+        return false; // if current token is not CBR
+    }
+
+    // get condition register
+    if (lookahead.type != TOKEN_REGISTER) {
+        std::cerr << "Error (line " << lookahead.line << "): Expected register after CBR." << std::endl;
+        return false;
+    }
+    node->sr1 = getRegisterNumber(lookahead.lexeme);
+    lookahead = scanner.nextToken();
+
+    // parse arrow
+    if (!expect(TOKEN_CF_ARROW, "Expected '->' after register in CBR.")) {
+        return false;
+    }
+
+    // get both target labels
+    for (int target = 0; target < 2; target++) {
+        if (target == 1 && !expect(TOKEN_COMMA, "Expected ',' between labels in CBR.")) {
+            return false;
+        }
+        if (lookahead.type != TOKEN_NAME) {
+            std::cerr << "Error (line " << lookahead.line << "): Expected label in CBR." << std::endl;
+            return false;
+        }
+        int id = getLabelId(lookahead.lexeme);
+        if (labelUsedAt[id] < 0) {
+            labelUsedAt[id] = lookahead.line;
+        }
+        (target == 0 ? node->sr2 : node->sr3) = id;
+        lookahead = scanner.nextToken();
+    }
+
+    // expect end of line
+    if (lookahead.type != TOKEN_EOL && lookahead.type != TOKEN_EOF) {
+        std::cerr << "Error (line " << lookahead.line << "): Expected end of line after CBR operation." << std::endl;
+        return false;
+    }
+
+    if (lookahead.type == TOKEN_EOL) {
+        lookahead = scanner.nextToken(); //consume EOL
+    }
+
+    return true;
+}
+
 // IR printing functions
 void Parser::printIR() {
     if (head == nullptr) {
@@ -400,10 +552,15 @@ std::string Parser::tokenTypeToString(TokenType t) {
         case TOKEN_RSHIFT: return "RSHIFT";
         case TOKEN_OUTPUT: return "OUTPUT";
         case TOKEN_NOP: return "NOP";
+        case TOKEN_JUMPI: return "JUMPI";
+        case TOKEN_CBR: return "CBR";
         case TOKEN_REGISTER: return "REGISTER";
         case TOKEN_CONSTANT: return "CONSTANT";
         case TOKEN_COMMA: return "COMMA";
         case TOKEN_ARROW: return "ARROW";
+        case TOKEN_CF_ARROW: return "CF_ARROW";
+        case TOKEN_LABEL: return "LABEL";
+        case TOKEN_NAME: return "NAME";
         case TOKEN_EOL: return "EOL";
         case TOKEN_EOF: return "EOF";
         case TOKEN_ERROR: return "ERROR";
@@ -444,6 +601,20 @@ void Parser::printIRNode(IRNode* node) {
             // no operands
             break;
 
+        case TOKEN_LABEL:
+            std::cout << " [ " << labels[node->sr1] << " ]";
+            break;
+
+        case TOKEN_JUMPI:
+            std::cout << " -> [ " << labels[node->sr1] << " ]";
+            break;
+
+        case TOKEN_CBR:
+            std::cout << " [ SR1: r" << node->sr1
+                      << " ] -> [ " << labels[node->sr2]
+                      << " , " << labels[node->sr3] << " ]";
+            break;
+
         default:
             break;
     }
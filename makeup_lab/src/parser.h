@@ -1,8 +1,13 @@
 #pragma once
 #include "scanner.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 struct IRNode {
-    //  Intermediate Representation Node structure
+    //  Intermediate Representation Node structure. Control flow reuses the
+    //  operand fields: a label (TOKEN_LABEL) and jumpI keep a label id in
+    //  sr1; cbr keeps its register in sr1 and its two targets in sr2 / sr3
     int line;
     TokenType opcode;
 
@@ -22,6 +27,9 @@ public:
     IRNode* parseAll(); // return head of IR linked list
     void printIR(); //print the IR linked list
 
+    // label names by id, for printing
+    const std::vector<std::string>& labelNames() const { return labels; }
+
 private:
     Scanner& scanner;
     Token lookahead;
@@ -29,6 +37,11 @@ private:
     IRNode* head = nullptr; // head of IR linked list
     IRNode* tail = nullptr; // tail of IR linked list
 
+    std::vector<std::string> labels; // label id -> name
+    std::unordered_map<std::string, int> labelIds; // name -> label id
+    std::vector<int> labelDefinedAt; // label id -> line of its definition (-1 = none yet)
+    std::vector<int> labelUsedAt; // label id -> line of its first use as a target
+
     //helper functions
     bool match(TokenType expected);
     bool expect(TokenType expected, const std::string& errorMessage);
@@ -36,6 +49,8 @@ private:
     int getRegisterNumber(const std::string& lexeme);
     int getConstantValue(const std::string& lexeme);
     void skiptoEOL();
+    int getLabelId(const std::string& name);
+    bool checkLabels();
 
     //parsing functions
     bool parseOperation();
@@ -45,6 +60,9 @@ private:
     bool parseArithmetic(IRNode* node);
     bool parseOutput(IRNode* node);
     bool parseNop(IRNode* );
+    bool parseLabel();
+    bool parseJumpI(IRNode* node);
+    bool parseCbr(IRNode* node);
 
     // IR printing helper
     std::string tokenTypeToString(TokenType T);
@@ -1,9 +1,12 @@
 #include "scanner.h"
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <unordered_map>
 
-//map to identify opcode
-std::unordered_map<std::string, TokenType> opcodeMap = {
+//map to identify opcode; const and local to this file, so scanners on
+//different threads only ever read it
+static const std::unordered_map<std::string, TokenType> opcodeMap = {
     {"load", TOKEN_LOAD},
     {"loadI", TOKEN_LOADI},
     {"store", TOKEN_STORE},
@@ -13,12 +16,14 @@ std::unordered_map<std::string, TokenType> opcodeMap = {
     {"lshift", TOKEN_LSHIFT},
     {"rshift", TOKEN_RSHIFT},
     {"output", TOKEN_OUTPUT},
-    {"nop", TOKEN_NOP}
+    {"nop", TOKEN_NOP},
+    {"jumpI", TOKEN_JUMPI},
+    {"cbr", TOKEN_CBR}
 };
 
 //constructor
 Scanner::Scanner(const std::string& filename) 
-    : curr_size(0), pos(0), line(1) {
+    : memory(nullptr), memorySize(0), memoryPos(0), curr_size(0), pos(0), line(1) {
     
     input.open(filename);
     if (!input.is_open()) {
@@ -31,7 +36,21 @@ Scanner::Scanner(const std::string& filename)
 }
 
 
+Scanner::Scanner(const char* data, size_t size)
+    : memory(data), memorySize(size), memoryPos(0), curr_size(0), pos(0), line(1) {
+    fillBuffer();
+}
+
+
 bool Scanner::fillBuffer() {
+    if (memory) {
+        curr_size = std::min(BUFSIZE, memorySize - memoryPos);
+        std::memcpy(buffer, memory + memoryPos, curr_size);
+        memoryPos += curr_size;
+        pos = 0;
+        return curr_size > 0;
+    }
+
     //check if input is good
     if (!input.good()) {
         curr_size = 0;
@@ -124,6 +143,15 @@ Token Scanner::nextToken() {
             return {TOKEN_ERROR, line, "="};
         }
 
+        case '-': {
+            get();
+            if (peek() == '>') { //branch arrow
+                get();
+                return {TOKEN_CF_ARROW, line, "->"};
+            }
+            return {TOKEN_ERROR, line, "-"};
+        }
+
         default:
             break;
     }
@@ -152,11 +180,17 @@ Token Scanner::nextToken() {
         }
 
         // check opcode map
-        if (opcodeMap.count(lex)) {
-            return {opcodeMap[lex], line, lex};
+        auto opcode = opcodeMap.find(lex);
+        if (opcode != opcodeMap.end()) {
+            return {opcode->second, line, lex};
         }
 
-        return {TOKEN_ERROR, line, lex};
+        // label definition or branch target
+        if (peek() == ':') {
+            get();
+            return {TOKEN_LABEL, line, lex};
+        }
+        return {TOKEN_NAME, line, lex};
     }
 
 
@@ -189,10 +223,15 @@ std::string Scanner::tokenTypetoString(TokenType t) {
         case TOKEN_RSHIFT: return "RSHIFT";
         case TOKEN_OUTPUT: return "OUTPUT";
         case TOKEN_NOP: return "NOP";
+        case TOKEN_JUMPI: return "JUMPI";
+        case TOKEN_CBR: return "CBR";
         case TOKEN_REGISTER: return "REGISTER";
         case TOKEN_CONSTANT: return "CONSTANT";
         case TOKEN_COMMA: return "COMMA";
         case TOKEN_ARROW: return "ARROW";
+        case TOKEN_CF_ARROW: return "CF_ARROW";
+        case TOKEN_LABEL: return "LABEL";
+        case TOKEN_NAME: return "NAME";
         case TOKEN_EOL: return "EOL";
         case TOKEN_EOF: return "EOF";
         case TOKEN_ERROR: return "ERROR";
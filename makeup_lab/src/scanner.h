@@ -18,11 +18,16 @@ enum TokenType {
     TOKEN_RSHIFT,
     TOKEN_OUTPUT,
     TOKEN_NOP,
+    TOKEN_JUMPI,
+    TOKEN_CBR,
 
     TOKEN_REGISTER,   //r followed by digits
     TOKEN_CONSTANT,   // non negative integer
     TOKEN_COMMA,   // ,
     TOKEN_ARROW,   // =>
+    TOKEN_CF_ARROW,   // -> (branch targets)
+    TOKEN_LABEL,   // name followed by ':' (starts a block)
+    TOKEN_NAME,   // label used as a branch target
     TOKEN_EOL,  // end of line
     TOKEN_EOF,  // end of file
     TOKEN_ERROR  // error
@@ -43,6 +48,9 @@ private:
     static constexpr size_t BUFSIZE = 16 * 1024; //buffer size (using 16kb buffer b/c 120,000 lines)
 
     std::ifstream input;   // file input stream
+    const char* memory;    // in-memory input instead of the file, or nullptr
+    size_t memorySize;
+    size_t memoryPos;
     char buffer[BUFSIZE];   //input buffer
 
     size_t curr_size;   //num char is current buffer
@@ -63,6 +71,9 @@ public:
     //explicit constructor to prevent type conversions
     explicit Scanner(const std::string& filename);
 
+    // scan `size` bytes at `data`, which must outlive the scanner
+    Scanner(const char* data, size_t size);
+
     Token nextToken();
     void scanAll();  //for -s flag
 };
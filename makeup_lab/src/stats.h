@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// --stats: wall time, CPU time, heap allocations and peak RSS for each
+// phase of a run. A disabled PhaseStats costs one branch per phase.
+class PhaseStats {
+public:
+    // times everything from construction to destruction; phases with the
+    // same name add up, so a phase run once per candidate reports the total
+    class Scope {
+    public:
+        Scope(PhaseStats& stats, const char* name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PhaseStats& stats;
+        const char* name;
+        double wallStart;
+        double cpuStart;
+        uint64_t allocationsStart;
+        uint64_t bytesStart;
+    };
+
+    PhaseStats(const std::string& tool, bool enabled);
+
+    bool enabled() const { return on; }
+
+    // a table for people, or one JSON object per run for CI
+    void print(std::ostream& out, bool json) const;
+
+private:
+    struct Phase {
+        std::string name;
+        int runs;
+        double wallMs;
+        double cpuMs;            // all threads of the process
+        uint64_t allocations;    // calls to operator new
+        uint64_t bytes;          // bytes they asked for
+        long peakRssKb;          // high-water mark when the phase last ended
+    };
+
+    std::string tool;
+    bool on;
+    double wallStart;
+    double cpuStart;
+    std::vector<Phase> phases;   // in the order they first ran
+
+    void record(const char* name, double wallMs, double cpuMs, uint64_t allocations, uint64_t bytes);
+};